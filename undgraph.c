@@ -22,6 +22,35 @@
  * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE 1
+#endif
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN 1
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#if UNDGRAPH_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
 #include <assert.h>
 #include <errno.h>
 #include <float.h>
@@ -30,30 +59,649 @@
 #include <limits.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UNDGRAPH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if UNDGRAPH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if UNDGRAPH_HAVE_ZSTD
+/* for ZSTD_createDStream_advanced */
+#define ZSTD_STATIC_LINKING_ONLY 1
+#include <zstd.h>
+#endif
+
+/* without zlib stb encodes the pngs, allocating from the per-file arena */
+#if !UNDGRAPH_HAVE_ZLIB
+static void *stbiw_malloc(size_t size);
+static void *stbiw_realloc(void *ptr, size_t old_size, size_t new_size);
+static void stbiw_free(void *ptr);
+#define STBIW_MALLOC(sz) stbiw_malloc(sz)
+#define STBIW_REALLOC_SIZED(p, oldsz, newsz) stbiw_realloc(p, oldsz, newsz)
+#define STBIW_FREE(p) stbiw_free(p)
+
 #define STB_IMAGE_WRITE_IMPLEMENTATION 1
 #include "stb_image_write.h"
+#endif
 
 #define MACROSTR1(x) #x
 #define MACROSTR2(x) MACROSTR1(x)
 
+#define PI (3.14159265358979323846)
+
 #define WIDTH   (1152)
 #define HEIGHT  (648)
 #define COLOR_R (0)
 #define COLOR_G (255)
 #define COLOR_B (0)
+#define SERIES_COLOR ((COLOR_R << 16) | (COLOR_G << 8) | COLOR_B)
+
+/* samples per block of the compressed sample store */
+#define SAMPLES_PER_BLOCK (4096)
+
+/* derived series drawn over the samples, and the prefix sum block length */
+#define MAX_OVERLAYS (6)
+#define PREFIX_BLOCK (65536)
+
+/* the histogram view: bin limit, counters per worker and the cdf color */
+#define MAX_BINS   (65536)
+#define HIST_LANES (4)
+#define CDF_COLOR  (0xFF8000)
+
+/* the spectrum view: largest transform and the dB range it shows */
+#define MAX_FFT          (1 << 20)
+#define SPECTRUM_RANGE_DB (120.0f)
+
+/* the envelope view: one band column per pixel, drawn dimmer than a line */
+#define ENVELOPE_COLUMNS (WIDTH)
+#define ENVELOPE_COLOR   (0x008000)
+
+/* --diff: share of the frame under the delta panel, and the colors of
+ * the second file and of the delta */
+#define DIFF_PANEL   (0.3)
+#define DIFF_B_COLOR (0x00A0FF)
+#define DELTA_COLOR  (0xFF8000)
+
+/* streaming png: IDAT payload per chunk, rows per readback band and
+ * the deflate level */
+#define PNG_IDAT_SIZE (65536)
+#define PNG_BAND_ROWS (64)
+#define PNG_LEVEL     (6)
+
+/* --summary: the quantiles it prints and the digit width of the radix
+ * selection passes, 11 + 11 + 10 bits of each key */
+#define NUM_QUANTILES (4)
+#define SELECT_BITS   (11)
+#define SELECT_BINS   (1 << SELECT_BITS)
+
+/* --sheet: thumbnail cell size and the space around each plot, and the
+ * largest canvas */
+#define SHEET_CELL_W   (192)
+#define SHEET_CELL_H   (108)
+#define SHEET_PAD      (6)
+#define SHEET_MAX_SIZE (8192)
+
+/* --animate: the default step as a part of the window, frames in flight
+ * to the encoders and the y4m frame rate */
+#define ANIM_STEP  (32)
+#define ANIM_SLOTS (4)
+#define ANIM_FPS   (30)
+
+/* alert rules: the default sigma window, runs kept per file, runs per
+ * hand-over, markers drawn and lines printed at most */
+#define SIGMA_WINDOW   (1024)
+#define MAX_ALERT_RUNS (65536)
+#define ALERT_BATCH    (64)
+#define MAX_MARKERS    (1024)
+#define MAX_REPORTED   (100)
+
+/* strips draw_graph can be asked to draw */
+#define MAX_STRIPS (16)
+
+/* axes:1: the glyph atlas, label size, gridline count and colors */
+#define FONT_WIDTH       (5)
+#define FONT_HEIGHT      (7)
+#define FONT_CELL        (8)
+#define FONT_SOLID       (15)
+#define FONT_ATLAS_WIDTH (FONT_CELL * 16)
+#define LABEL_SCALE      (2)
+#define MAX_QUADS        (1024)
+#define AXIS_TICKS       (8)
+#define GRID_COLOR       (0x303030)
+#define AXIS_COLOR       (0x808080)
+#define LABEL_COLOR      (0xC0C0C0)
+
+/* quantile sketch compression and its centroid and buffer sizes */
+#define TDIGEST_DELTA     (300)
+#define TDIGEST_CENTROIDS (TDIGEST_DELTA)
+#define TDIGEST_BUFFER    (TDIGEST_DELTA * 5)
+
+/* --follow: samples kept on screen, read size and reads per frame, and
+ * the p50/p99/p999/max reference lines */
+#define FOLLOW_WINDOW (65536)
+#define FOLLOW_CHUNK  (65536)
+#define FOLLOW_ROUNDS (16)
+#define NUM_REFLINES  (4)
+
+/* --replay: blocks taken in per call at most */
+#define REPLAY_BLOCKS (256)
+
+#define JOURNAL_MAGIC   "UNDGJRN1"
+#define JOURNAL_VERSION (1)
+
+/* history:N: buckets of HISTORY_FACTOR samples, then of HISTORY_FACTOR
+ * of those, N buckets to a tier */
+#define HISTORY_TIERS  (2)
+#define HISTORY_FACTOR (10)
+
+#define BLOCKFILE_MAGIC         "UNDGRAPH"
+#define BLOCKFILE_VERSION       (1)
+#define BLOCKFILE_HEADER_SIZE   (56)
+#define BLOCKFILE_ENTRY_SIZE    (32)
+
+/* line-offset index kept next to a text file */
+#define LINEINDEX_MAGIC         "UNDGIDX1"
+#define LINEINDEX_HEADER_SIZE   (32)
+#define LINEINDEX_ENTRY_SIZE    (16)
+
+/* text loading pipeline */
+#define CHUNK_SIZE  (1 << 20)
+#define QUEUE_DEPTH (8)
+#define HEADER_SIZE (256)
+
+/* work-stealing pool */
+#define MAX_WORKERS (64)
+#define DEQUE_SIZE  (1024)
+#define MAX_TASKS   (256)
+
+/* numa topology */
+#define MAX_NODES   (8)
+#define MAX_CPUS    (1024)
+#define NODE_GRAIN  (16)
+
+/* file reads kept in flight by the loader */
+#define IO_DEPTH        (4)
+#define IO_BUFFER_SIZE  (1 << 20)
+#define IO_ALIGNMENT    (4096)
+
+/* buffers at least this large get their own huge-page-backed mapping */
+#define HUGE_PAGE_SIZE (2 << 20)
+
+#define BENCH_ROUNDS (8)
+
+/* per-file arena */
+#define ARENA_HEADER    (64)
+#define ARENA_ALIGNMENT (64)
+#define ARENA_MIN_CHUNK (4 << 20)
 
 typedef float vec2_t[2];
 
+#if defined(_WIN32)
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+#else
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+#endif
+
+typedef intptr_t atom_t;
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+struct thread_s {
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    void (*func)(void *arg);
+    void *arg;
+};
+
+struct arenachunk_s {
+    struct arenachunk_s *next;
+    size_t size;
+    size_t used;
+};
+
+struct arena_s {
+    mutex_t lock;
+    size_t capacity;
+    struct arenachunk_s *chunks;
+    void *last;
+    size_t last_used;
+};
+
+struct taskgroup_s {
+    volatile atom_t pending;
+};
+
+struct task_s {
+    void (*func)(void *arg, size_t index);
+    void *arg;
+    size_t index;
+    struct taskgroup_s *group;
+};
+
+/* top and bottom live on separate cache lines */
+struct deque_s {
+    volatile atom_t top;
+    char pad0[64 - sizeof(atom_t)];
+    volatile atom_t bottom;
+    char pad1[64 - sizeof(atom_t)];
+    volatile atom_t tasks[DEQUE_SIZE];
+    size_t executed;
+    size_t steals;
+};
+
+struct pool_s {
+    int num_workers;
+    int num_started;
+    struct deque_s *deques;
+    struct thread_s *threads;
+    volatile atom_t pending;
+    volatile atom_t sleepers;
+    volatile atom_t shutdown;
+    mutex_t lock;
+    cond_t wake;
+    int num_nodes;
+    unsigned char cpu_node[MAX_CPUS];
+#if defined(__linux__)
+    cpu_set_t node_cpus[MAX_NODES];
+#endif
+};
+
+/* items split into one contiguous range per numa node */
+struct nodejob_s {
+    void (*func)(void *arg, size_t begin, size_t end);
+    void *arg;
+    size_t count;
+    size_t item_bytes;
+    volatile atom_t next[MAX_NODES];
+    mutex_t lock;
+    int node_threads[MAX_NODES];
+    double node_time[MAX_NODES];
+    size_t node_bytes[MAX_NODES];
+};
+
+enum {
+    CODEC_RAW = 0,  /* plain float32 */
+    CODEC_DELTA,    /* integer deltas, bucketed bit-packing */
+    CODEC_DOD,      /* integer delta-of-deltas, bucketed bit-packing */
+    CODEC_XOR       /* gorilla-style float xor */
+};
+
+/* above:X, below:X, slope:X and sigma:N[:W]; rules has a bit per rule */
+enum {
+    RULE_ABOVE = 0,
+    RULE_BELOW,
+    RULE_SLOPE,
+    RULE_SIGMA,
+    NUM_RULES
+};
+
+struct alerts_s {
+    int rules;
+    float above;
+    float below;
+    float slope;
+    float sigma;
+    size_t window;
+};
+
+/* consecutive samples that broke one rule, and the worst of them */
+struct alertrun_s {
+    int rule;
+    size_t first;
+    size_t last;
+    float peak;
+};
+
+struct alertlist_s {
+    struct alertrun_s *runs;
+    size_t count;
+    size_t capacity;
+    size_t dropped;
+    mutex_t lock;
+};
+
+/* what one scan found, handed over to the list ALERT_BATCH at a time */
+struct alertscan_s {
+    const struct alerts_s *alerts;
+    struct alertlist_s *list;
+    size_t index;
+    struct alertrun_s runs[ALERT_BATCH];
+    size_t count;
+    int open[NUM_RULES];
+};
+
+struct sampleblock_s {
+    int codec;
+    size_t count;
+    size_t offset;
+    size_t nbytes;
+    float min_value;
+    float max_value;
+};
+
+struct samplestore_s {
+    size_t num_blocks;
+    struct sampleblock_s *blocks;
+    size_t nbytes;
+    unsigned char *bytes;
+};
+
+enum {
+    INPUT_PLAIN = 0,
+    INPUT_GZIP,
+    INPUT_ZSTD
+};
+
+struct ioreader_s {
+    struct arena_s *arena;
+    FILE *fp;
+    int fd;
+    int direct;
+    int uring;
+    int eof;
+    uint64_t offset;
+    size_t head;
+    size_t inflight;
+    unsigned char *bufs[IO_DEPTH];
+    uint64_t offsets[IO_DEPTH];
+    size_t lens[IO_DEPTH];
+    int ready[IO_DEPTH];
+    double io_start;
+    double io_end;
+    double io_wait;
+    uint64_t io_bytes;
+#if UNDGRAPH_HAVE_IO_URING
+    int ring_fd;
+    size_t sq_size;
+    size_t cq_size;
+    unsigned num_sqes;
+    void *sq_ring;
+    void *cq_ring;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+#endif
+};
+
+struct instream_s {
+    int kind;
+    int eof;
+    size_t skip;
+    struct ioreader_s io;
+    const unsigned char *inbuf;
+    size_t inpos;
+    size_t inlen;
+#if UNDGRAPH_HAVE_ZLIB
+    z_stream zs;
+#endif
+#if UNDGRAPH_HAVE_ZSTD
+    ZSTD_DStream *zds;
+#endif
+};
+
+struct chunk_s {
+    struct task_s task;
+    struct pipeline_s *pl;
+    size_t seq;
+    size_t first_line;
+    size_t lines;
+    size_t len;
+    char *bytes;
+    int stop;
+    size_t count;
+    float *values;
+    float min_value;
+    float max_value;
+};
+
+struct pipeline_s {
+    struct arena_s *arena;
+    struct instream_s *in;
+    int select;
+    size_t begin;
+    size_t end;
+    size_t stride;
+    size_t line;
+    uint64_t offset;
+    int build_index;
+    size_t num_marks;
+    uint64_t *marks;
+    size_t bytes_in;
+    double parse_time;
+    volatile atom_t stopped;
+    volatile atom_t outstanding;
+    float *scratch[MAX_WORKERS];
+    mutex_t lock;
+    size_t num_chunks;
+    struct chunk_s **chunks;
+    size_t num_spare;
+    char *spare[QUEUE_DEPTH + MAX_WORKERS + 1];
+};
+
+/* a derived series drawn over the samples */
+struct overlay_s {
+    const char *name;
+    unsigned color;
+    float *values;
+};
+
+/* rolling window state, advanced one sample at a time; the memory for
+ * the window comes from the caller, see the *_bytes helpers */
+struct rollmean_s {
+    size_t window;
+    size_t count;
+    double sum;
+    float *ring;
+};
+
+struct ewma_s {
+    double alpha;
+    double value;
+    size_t count;
+};
+
+struct rollminmax_s {
+    size_t window;
+    size_t mask;
+    size_t count;
+    float *ring;
+    size_t *min_queue;
+    size_t *max_queue;
+    size_t min_head, min_len;
+    size_t max_head, max_len;
+};
+
+struct treapnode_s {
+    float key;
+    uint32_t priority;
+    int left;
+    int right;
+    int size;
+};
+
+struct rollpct_s {
+    size_t window;
+    size_t count;
+    uint32_t seed;
+    int root;
+    struct treapnode_s *nodes;
+};
+
+struct centroid_s {
+    double mean;
+    double weight;
+};
+
+/* merging t-digest with a fixed centroid budget; adds are buffered and
+ * folded in with a sorted sweep, so memory and the cost per sample do
+ * not grow with the number of samples seen */
+struct tdigest_s {
+    size_t num_centroids;
+    size_t num_buffered;
+    double total;
+    double min;
+    double max;
+    struct centroid_s centroids[TDIGEST_CENTROIDS];
+    struct centroid_s buffer[TDIGEST_BUFFER];
+    struct centroid_s merged[TDIGEST_CENTROIDS + TDIGEST_BUFFER];
+};
+
+/* one level of history:N; the buckets are a ring of capacity, the last
+ * one still filling from fill inputs of the level below */
+struct tier_s {
+    float *lo;
+    float *hi;
+    float *mean;
+    size_t capacity;
+    size_t count;
+    size_t factor;
+    size_t fill;
+    size_t n;
+    size_t finite;
+    float acc_lo;
+    float acc_hi;
+    double acc_sum;
+};
+
+struct follow_s {
+    FILE *fp;
+    const char *filename;
+    uint64_t offset;
+    char *buffer;
+    size_t len;
+    size_t count;
+    size_t nan_count;
+    float *ring;
+    int num_overlays;
+    float *rings[MAX_OVERLAYS];
+    float window_max;
+    struct rollminmax_s range;
+    struct rollmean_s ma;
+    struct ewma_s ewma;
+    struct rollminmax_s minmax;
+    struct rollpct_s pct;
+    struct tdigest_s *digest;
+    double refs[NUM_REFLINES];
+    double title_time;
+    int dirty;
+    vec2_t *mesh;
+    int allocated;
+    int x0;
+    int columns;
+    size_t column_samples;
+    size_t column;
+    float scale;
+    size_t raw_first;
+    struct tier_s tiers[HISTORY_TIERS];
+    float *batch;
+    unsigned char *payload;
+    FILE *journal;
+    double journal_start;
+    size_t sync_every;
+    size_t journal_batches;
+    FILE *replay;
+    double replay_start;
+    double replay_speed;
+    int replay_pending;
+    int replay_done;
+    int replay_reported;
+    uint64_t replay_time;
+    size_t replay_count;
+    size_t replay_nbytes;
+    int replay_codec;
+    size_t replay_samples;
+    struct alerts_s alerts;
+    struct alertlist_s alert_list;
+    float *alert_history;
+    size_t alert_last[NUM_RULES];
+    int alert_seen[NUM_RULES];
+};
+
+/* a range of glvbo and how to draw it */
+struct glstrip_s {
+    GLenum mode;
+    GLint first;
+    GLsizei count;
+    unsigned color;
+};
+
+/* one instance of the axes draw: a rect in pixels, its atlas coordinates
+ * and a color */
+struct quad_s {
+    float rect[4];
+    float uv[4];
+    unsigned char color[4];
+};
+
+/* the values the frame edges stand for in the current view */
+struct axes_s {
+    double x0;
+    double x1;
+    double y0;
+    double y1;
+    double y_step;
+    double y_first;
+};
+
+struct fftplan_s {
+    size_t n;
+    size_t length;
+    uint32_t *rev;
+    float *window;
+    double window_power;
+    float *twiddles;
+};
+
 struct graphdata_s {
     /* tags */
     int msaa;
     int save;
+    int compress;
     float line_width;
     float frame_px;
+    size_t lttb;
+    size_t ma_window;
+    float ewma_alpha;
+    size_t minmax_window;
+    size_t pct_window;
+    size_t hist_bins;
+    int cdf;
+    size_t fft_size;
+    int envelope;
+    int envelope_mean;
+    int axes;
+    size_t history;
+
+    /* loading */
+    struct arena_s *arena;
+    int direct_io;
+    size_t range_begin;
+    size_t range_end;
+    size_t stride;
+    int build_index;
 
     /* calculated */    
     float max_value;
@@ -61,338 +709,7845 @@ struct graphdata_s {
     float tick_size;
     size_t size;
     float *data;
+    struct samplestore_s store;
+    int num_overlays;
+    struct overlay_s overlays[MAX_OVERLAYS];
+    size_t *histogram;
+    float *spectrum;
+    size_t spectrum_bins;
+    float *columns;
+
+    /* --diff: the second file's samples, b minus a and b over a for the
+     * samples both have, and what the two panels span */
+    const float *other;
+    float *delta;
+    float *ratio;
+    size_t diff_size;
+    int diff_ratio;
+    float diff_top;
+    float diff_lo[2];
+    float diff_hi[2];
+
+    /* alerts; scanned is set once the loader checked the rules */
+    struct alerts_s alerts;
+    struct alertlist_s alert_list;
+    int alerts_scanned;
+};
+
+struct options_s {
+    int num_files;
+    const char **files;
+    const char *pack_filename;
+    int force_msaa;
+    int force_save;
+    int force_compress;
+    int direct_io;
+    int bench;
+    int batch;
+    int build_index;
+    size_t range_begin;
+    size_t range_end;
+    size_t stride;
+    size_t downsample;
+    size_t hist_bins;
+    int cdf;
+    size_t fft_size;
+    int envelope;
+    int axes;
+    int follow;
+    size_t history;
+    const char *record_filename;
+    const char *replay_filename;
+    struct alerts_s alerts;
+    const char *alerts_filename;
+    int check;
+    size_t sync_every;
+    double replay_speed;
+    const char *diff_filenames[2];
+    int diff_ratio;
+    size_t anim_window;
+    size_t anim_step;
+    int y4m;
+    const char *sheet_filename;
+    int summary;
+    int json;
+};
+
+/* one file in flight through batch mode */
+struct batchslot_s {
+    struct task_s task;
+    struct taskgroup_s group;
+    struct arena_s arena;
+    struct graphdata_s data;
+    const char *filename;
+    int active;
+    int loaded;
+    int saved;
+    char *pixels;
 };
 
+/* png written as the rows come: each row is filtered against the one
+ * above it, deflated (stored without zlib) and the output leaves as an
+ * IDAT chunk whenever PNG_IDAT_SIZE bytes are ready. a few rows, the
+ * chunk and the deflate state are all it holds */
+struct pngwriter_s {
+    int (*write)(void *ctx, const void *bytes, size_t size);
+    void *ctx;
+    size_t row_bytes;
+    int channels;
+    int rows_left;
+    int failed;
+    unsigned char *prev;
+    unsigned char *best;
+    unsigned char *trial;
+    unsigned char *out;
+    size_t out_used;
+#if UNDGRAPH_HAVE_ZLIB
+    z_stream zs;
+#else
+    uint32_t adler_a;
+    uint32_t adler_b;
+#endif
+};
+
+/* one thumbnail's draw, laid out as glMultiDrawArraysIndirect reads it */
+struct drawcmd_s {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first;
+    GLuint base_instance;
+};
+
+/* --sheet: files are taken in turn by the loading tasks */
+struct sheetjob_s {
+    const char **filenames;
+    size_t num_files;
+    volatile atom_t next;
+    volatile atom_t failed;
+    vec2_t *mesh;
+    struct drawcmd_s *cmds;
+};
+
+/* one frame in flight through --animate */
+struct frameslot_s {
+    struct task_s task;
+    struct taskgroup_s group;
+    struct arena_s arena;
+    const char *filename;
+    size_t frame;
+    int active;
+    int saved;
+    char *pixels;
+    unsigned char *yuv;
+};
+
+static struct options_s options = { 0 };
+static struct arena_s file_arena;
+/* every big_alloc, arena chunks included; zlib, zstd and stb allocate
+ * from the arenas. what the c library and glfw allocate on their own,
+ * such as the FILE behind each fopen, and the io_uring rings mapped per
+ * file are not seen */
+static volatile atom_t heap_allocs = 0;
+static struct pool_s pool;
+static THREAD_LOCAL int worker_index = 0;
+static THREAD_LOCAL unsigned steal_seed = 2463534242U;
+#if !UNDGRAPH_HAVE_ZLIB
+static THREAD_LOCAL struct arena_s *stbiw_arena = NULL;
+#endif
 static struct graphdata_s graphdata = { 0 };
 static GLFWwindow *window = NULL;
 static GLuint glprogram = 0;
 static GLuint glvao = 0;
 static GLuint glvbo = 0;
+static struct glstrip_s glstrips[MAX_STRIPS];
+static int glnumstrips = 0;
+static GLuint glquadprogram = 0;
+static GLuint glquadvao = 0;
+static GLuint glquadvbo = 0;
+static GLuint glfont = 0;
+static GLsizei glnumquads = 0;
+static GLuint glscrollprogram = 0;
+static GLuint glscrolltex = 0;
+static GLuint glscrollfbo = 0;
+static int glpanning = 0;
+static struct axes_s glaxes;
+static const unsigned refline_colors[NUM_REFLINES] = { 0xFFFFFF, 0xFFFF00, 0xFF8000, 0xFF0000 };
+static const unsigned marker_colors[NUM_RULES] = { 0xFF0000, 0x0080FF, 0xFF00FF, 0xFFFF00 };
+static FILE *alert_file = NULL;
+static const double summary_quantiles[NUM_QUANTILES] = { 0.5, 0.9, 0.99, 0.999 };
+static const char *summary_names[NUM_QUANTILES] = { "p50", "p90", "p99", "p999" };
 
 static const char *glsl_v =
     "#version 450\n"
     "const int WIDTH = " MACROSTR2(WIDTH) ";\n"
     "const int HEIGHT = " MACROSTR2(HEIGHT) ";\n"
     "layout(location = 0) in vec2 position;"
+    "layout(location = 1) uniform vec2 view;"
     "void main(void)\n"
     "{\n"
-    "gl_Position = vec4(vec2(position.x / WIDTH, position.y / HEIGHT) * 2.0 - 1.0, 0.0, 1.0);\n"
+    "gl_Position = vec4(vec2((position.x * view.x + view.y) / WIDTH, position.y / HEIGHT) * 2.0 - 1.0, 0.0, 1.0);\n"
     "}\n";
 
 static const char *glsl_f =
     "#version 450\n"
+    "layout(location = 0) uniform vec3 color;\n"
+    "layout(location = 0) out vec4 target;\n"
+    "void main(void)\n"
+    "{\n"
+    "target = vec4(color, 1.0);\n"
+    "}\n";
+
+/* one instance per quad, the corner from the vertex id */
+static const char *glsl_quad_v =
+    "#version 450\n"
+    "const int WIDTH = " MACROSTR2(WIDTH) ";\n"
+    "const int HEIGHT = " MACROSTR2(HEIGHT) ";\n"
+    "layout(location = 0) in vec4 rect;\n"
+    "layout(location = 1) in vec4 uv;\n"
+    "layout(location = 2) in vec4 color;\n"
+    "out vec2 texcoord;\n"
+    "out vec4 tint;\n"
+    "void main(void)\n"
+    "{\n"
+    "vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "vec2 position = rect.xy + corner * rect.zw;\n"
+    "texcoord = mix(uv.xy, uv.zw, corner);\n"
+    "tint = color;\n"
+    "gl_Position = vec4(vec2(position.x / WIDTH, position.y / HEIGHT) * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *glsl_quad_f =
+    "#version 450\n"
+    "layout(binding = 0) uniform sampler2D atlas;\n"
+    "in vec2 texcoord;\n"
+    "in vec4 tint;\n"
+    "layout(location = 0) out vec4 target;\n"
+    "void main(void)\n"
+    "{\n"
+    "target = vec4(tint.rgb, tint.a * texture(atlas, texcoord).r);\n"
+    "}\n";
+
+/* the follow view's plot texture over the frame, read from offset on
+ * and wrapped around */
+static const char *glsl_scroll_v =
+    "#version 450\n"
+    "const int WIDTH = " MACROSTR2(WIDTH) ";\n"
+    "const int HEIGHT = " MACROSTR2(HEIGHT) ";\n"
+    "layout(location = 1) uniform vec4 rect;\n"
+    "out vec2 texcoord;\n"
+    "void main(void)\n"
+    "{\n"
+    "vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "vec2 position = mix(rect.xy, rect.zw, corner);\n"
+    "texcoord = corner;\n"
+    "gl_Position = vec4(vec2(position.x / WIDTH, position.y / HEIGHT) * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *glsl_scroll_f =
+    "#version 450\n"
+    "layout(binding = 0) uniform sampler2D plot;\n"
+    "layout(location = 0) uniform float offset;\n"
+    "in vec2 texcoord;\n"
     "layout(location = 0) out vec4 target;\n"
     "void main(void)\n"
     "{\n"
-    "target = vec4(vec3(" MACROSTR2(COLOR_R) ", " MACROSTR2(COLOR_G) ", " MACROSTR2(COLOR_B) ") / 255.0, 1.0);\n"
+    "target = texture(plot, vec2(texcoord.x + offset, texcoord.y));\n"
     "}\n";
 
-static void lprintf(const char *fmt, ...)
+/* --sheet: thumbnails in the unit square, each draw placed in its cell
+ * by the per instance rectangle its base instance picks */
+static const char *glsl_sheet_v =
+    "#version 450\n"
+    "layout(location = 0) in vec2 position;\n"
+    "layout(location = 1) in vec4 cell;\n"
+    "layout(location = 1) uniform vec2 canvas;\n"
+    "void main(void)\n"
+    "{\n"
+    "gl_Position = vec4((cell.xy + position * cell.zw) / canvas * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+/* 5x7 glyphs for what %g prints, a row per byte with the left column in
+ * bit 4; the cell after the last glyph is solid for lines */
+static const char font_chars[] = "0123456789.-+e";
+static const unsigned char font_glyphs[][FONT_HEIGHT] = {
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },
+    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },
+    { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E }
+};
+
+static void lprintf(const char *fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    vfprintf(stderr, fmt, va);
+    va_end(va);
+}
+
+static void on_glfw_error(int code, const char *message)
+{
+    lprintf("GLFW error %d: %s\n", code, message);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI thread_entry(LPVOID param)
+#else
+static void *thread_entry(void *param)
+#endif
+{
+    struct thread_s *thread = param;
+    thread->func(thread->arg);
+    return 0;
+}
+
+/* the thread struct has to outlive the thread */
+static int thread_create(struct thread_s *thread, void (*func)(void *arg), void *arg)
+{
+    thread->func = func;
+    thread->arg = arg;
+#if defined(_WIN32)
+    thread->handle = CreateThread(NULL, 0, &thread_entry, thread, 0, NULL);
+    return thread->handle != NULL;
+#else
+    return !pthread_create(&thread->handle, NULL, &thread_entry, thread);
+#endif
+}
+
+static void thread_join(struct thread_s *thread)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
+
+static void mutex_init(mutex_t *mutex)
+{
+#if defined(_WIN32)
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+static void mutex_destroy(mutex_t *mutex)
+{
+#if defined(_WIN32)
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+static void mutex_lock(mutex_t *mutex)
+{
+#if defined(_WIN32)
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+static void mutex_unlock(mutex_t *mutex)
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+static void cond_init(cond_t *cond)
+{
+#if defined(_WIN32)
+    InitializeConditionVariable(cond);
+#else
+    pthread_cond_init(cond, NULL);
+#endif
+}
+
+static void cond_destroy(cond_t *cond)
+{
+#if defined(_WIN32)
+    (void)cond;
+#else
+    pthread_cond_destroy(cond);
+#endif
+}
+
+static void cond_wait(cond_t *cond, mutex_t *mutex)
+{
+#if defined(_WIN32)
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+static void cond_broadcast(cond_t *cond)
+{
+#if defined(_WIN32)
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
+
+static int count_cpus(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (int)si.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+static double now_seconds(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+#endif
+}
+
+/* to the disk, not just the OS */
+static void sync_file(FILE *fp)
+{
+#if defined(_WIN32)
+    FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(fp)));
+#else
+    fsync(fileno(fp));
+#endif
+}
+
+#if defined(_MSC_VER)
+static atom_t atom_load(volatile atom_t *p)
+{
+    atom_t v = *p;
+    _ReadWriteBarrier();
+    return v;
+}
+
+static void atom_store(volatile atom_t *p, atom_t v)
+{
+    _ReadWriteBarrier();
+    *p = v;
+}
+
+static int atom_cas(volatile atom_t *p, atom_t expected, atom_t desired)
+{
+    return InterlockedCompareExchangePointer((PVOID volatile *)p, (PVOID)desired, (PVOID)expected) == (PVOID)expected;
+}
+
+static atom_t atom_add(volatile atom_t *p, atom_t v)
+{
+#if defined(_WIN64)
+    return InterlockedExchangeAdd64((LONG64 volatile *)p, v) + v;
+#else
+    return InterlockedExchangeAdd((LONG volatile *)p, v) + v;
+#endif
+}
+
+static void atom_fence(void)
+{
+    MemoryBarrier();
+}
+#else
+static atom_t atom_load(volatile atom_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void atom_store(volatile atom_t *p, atom_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int atom_cas(volatile atom_t *p, atom_t expected, atom_t desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+static atom_t atom_add(volatile atom_t *p, atom_t v)
+{
+    return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST);
+}
+
+static void atom_fence(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+#endif
+
+static void yield_thread(void)
+{
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+/* chase-lev: the owner pushes and takes at the bottom, thieves steal from the top */
+static int deque_push(struct deque_s *dq, struct task_s *task)
+{
+    atom_t b = atom_load(&dq->bottom);
+    atom_t t = atom_load(&dq->top);
+    if(b - t >= DEQUE_SIZE)
+        return 0;
+    atom_store(&dq->tasks[b & (DEQUE_SIZE - 1)], (atom_t)task);
+    atom_store(&dq->bottom, b + 1);
+    return 1;
+}
+
+static struct task_s *deque_take(struct deque_s *dq)
+{
+    atom_t t, b = atom_load(&dq->bottom) - 1;
+    struct task_s *task = NULL;
+
+    atom_store(&dq->bottom, b);
+    atom_fence();
+    t = atom_load(&dq->top);
+    if(t <= b) {
+        task = (struct task_s *)atom_load(&dq->tasks[b & (DEQUE_SIZE - 1)]);
+        if(t == b) {
+            /* last one left, race the thieves for it */
+            if(!atom_cas(&dq->top, t, t + 1))
+                task = NULL;
+            atom_store(&dq->bottom, b + 1);
+        }
+    }
+    else {
+        atom_store(&dq->bottom, b + 1);
+    }
+    return task;
+}
+
+static struct task_s *deque_steal(struct deque_s *dq)
+{
+    atom_t b, t = atom_load(&dq->top);
+    struct task_s *task;
+
+    atom_fence();
+    b = atom_load(&dq->bottom);
+    if(t >= b)
+        return NULL;
+    task = (struct task_s *)atom_load(&dq->tasks[t & (DEQUE_SIZE - 1)]);
+    if(!atom_cas(&dq->top, t, t + 1))
+        return NULL;
+    return task;
+}
+
+static struct task_s *find_task(int self)
+{
+    int i, victim, count = pool.num_workers + 1;
+    struct task_s *task;
+
+    task = deque_take(&pool.deques[self]);
+    if(!task) {
+        /* xorshift picks where to start stealing */
+        steal_seed ^= steal_seed << 13;
+        steal_seed ^= steal_seed >> 17;
+        steal_seed ^= steal_seed << 5;
+        victim = (int)(steal_seed % (unsigned)count);
+        for(i = 0; i < count && !task; i++, victim = (victim + 1) % count) {
+            if(victim == self)
+                continue;
+            task = deque_steal(&pool.deques[victim]);
+        }
+        if(task)
+            pool.deques[self].steals++;
+    }
+
+    if(task)
+        atom_add(&pool.pending, -1);
+    return task;
+}
+
+static void run_task(int self, struct task_s *task)
+{
+    struct taskgroup_s *group = task->group;
+    task->func(task->arg, task->index);
+    pool.deques[self].executed++;
+    atom_add(&group->pending, -1);
+}
+
+/* runs one queued task, if there is any, instead of idling */
+static void pool_help(void)
+{
+    struct task_s *task = find_task(worker_index);
+    if(task)
+        run_task(worker_index, task);
+    else
+        yield_thread();
+}
+
+/* parses one sysfs cpulist, "0-3,8-11" */
+static int read_node_cpus(int node)
+{
+    int a, b, n;
+    char path[64], list[4096];
+    const char *p = list;
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    fp = fopen(path, "r");
+    if(!fp)
+        return 0;
+    if(!fgets(list, sizeof(list), fp)) {
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+
+    while(sscanf(p, "%d%n", &a, &n) == 1) {
+        p += n;
+        b = a;
+        if(*p == '-' && sscanf(p + 1, "%d%n", &b, &n) == 1)
+            p += 1 + n;
+        for(; a <= b && a < MAX_CPUS; a++) {
+            pool.cpu_node[a] = (unsigned char)node;
+#if defined(__linux__)
+            CPU_SET(a, &pool.node_cpus[node]);
+#endif
+        }
+        if(*p++ != ',')
+            break;
+    }
+
+    return 1;
+}
+
+static void read_numa_nodes(void)
+{
+    pool.num_nodes = 1;
+#if defined(__linux__)
+    while(pool.num_nodes < MAX_NODES && read_node_cpus(pool.num_nodes))
+        pool.num_nodes++;
+    if(pool.num_nodes > 1 && !read_node_cpus(0))
+        pool.num_nodes = 1;
+#endif
+
+    /* nothing to place on a single node */
+    if(pool.num_nodes == 1)
+        memset(pool.cpu_node, 0, sizeof(pool.cpu_node));
+}
+
+/* workers are dealt out to the nodes round-robin */
+static int worker_node(int index)
+{
+    return index ? (index - 1) % pool.num_nodes : 0;
+}
+
+static int current_node(void)
+{
+#if defined(__linux__)
+    int cpu;
+    if(pool.num_nodes > 1) {
+        cpu = sched_getcpu();
+        if(cpu >= 0 && cpu < MAX_CPUS)
+            return pool.cpu_node[cpu];
+    }
+#endif
+    return worker_node(worker_index);
+}
+
+static void pin_worker(int index)
+{
+#if defined(__linux__)
+    int node = worker_node(index);
+    if(pool.num_nodes > 1 && pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &pool.node_cpus[node]))
+        lprintf("pool: unable to pin worker %d to node %d\n", index, node);
+#endif
+    (void)index;
+}
+
+static void worker_main(void *arg)
+{
+    struct task_s *task;
+
+    worker_index = (int)(intptr_t)arg;
+    steal_seed = 2463534242U + (unsigned)worker_index * 7919U;
+    pin_worker(worker_index);
+
+    for(;;) {
+        task = find_task(worker_index);
+        if(task) {
+            run_task(worker_index, task);
+            continue;
+        }
+
+        mutex_lock(&pool.lock);
+        atom_add(&pool.sleepers, 1);
+        while(!atom_load(&pool.pending) && !atom_load(&pool.shutdown))
+            cond_wait(&pool.wake, &pool.lock);
+        atom_add(&pool.sleepers, -1);
+        mutex_unlock(&pool.lock);
+
+        if(atom_load(&pool.shutdown))
+            break;
+    }
+}
+
+static void pool_init(void)
+{
+    int i, total;
+    const char *env;
+
+    /* the main thread helps whenever it waits, so it counts as one */
+    total = count_cpus();
+    env = getenv("UNDGRAPH_THREADS");
+    if(env && atoi(env) > 0)
+        total = atoi(env);
+    if(total > MAX_WORKERS)
+        total = MAX_WORKERS;
+
+    memset(&pool, 0, sizeof(pool));
+    mutex_init(&pool.lock);
+    cond_init(&pool.wake);
+    pool.deques = calloc((size_t)total, sizeof(struct deque_s));
+    pool.threads = calloc((size_t)total, sizeof(struct thread_s));
+    assert(("Out of memory!", pool.deques && pool.threads));
+    read_numa_nodes();
+
+    /* set before any worker starts looking at it */
+    pool.num_workers = total - 1;
+    for(i = 1; i < total; i++) {
+        if(!thread_create(&pool.threads[i], &worker_main, (void *)(intptr_t)i)) {
+            /* its deque just stays empty */
+            lprintf("pool: unable to start worker %d\n", i);
+            break;
+        }
+        pool.num_started++;
+    }
+}
+
+static void pool_shutdown(void)
+{
+    int i;
+
+    mutex_lock(&pool.lock);
+    atom_store(&pool.shutdown, 1);
+    cond_broadcast(&pool.wake);
+    mutex_unlock(&pool.lock);
+
+    for(i = 1; i <= pool.num_started; i++)
+        thread_join(&pool.threads[i]);
+
+    cond_destroy(&pool.wake);
+    mutex_destroy(&pool.lock);
+    free(pool.threads);
+    free(pool.deques);
+    memset(&pool, 0, sizeof(pool));
+}
+
+/* number of threads that run tasks, the calling one included */
+static int pool_width(void)
+{
+    return pool.num_workers + 1;
+}
+
+static void pool_submit(struct taskgroup_s *group, struct task_s *task)
+{
+    task->group = group;
+    atom_add(&group->pending, 1);
+
+    /* a full deque means there is plenty to do already */
+    if(!deque_push(&pool.deques[worker_index], task)) {
+        run_task(worker_index, task);
+        return;
+    }
+
+    atom_add(&pool.pending, 1);
+    if(atom_load(&pool.sleepers)) {
+        mutex_lock(&pool.lock);
+        cond_broadcast(&pool.wake);
+        mutex_unlock(&pool.lock);
+    }
+}
+
+static void pool_wait(struct taskgroup_s *group)
+{
+    while(atom_load(&group->pending))
+        pool_help();
+}
+
+/* calls func(arg, 0..count-1) across the pool; count is at most MAX_TASKS */
+static void pool_parallel_for(size_t count, void (*func)(void *arg, size_t index), void *arg)
+{
+    size_t i;
+    struct task_s tasks[MAX_TASKS];
+    struct taskgroup_s group = { 0 };
+
+    assert(count <= MAX_TASKS);
+    for(i = 0; i < count; i++) {
+        tasks[i].func = func;
+        tasks[i].arg = arg;
+        tasks[i].index = i;
+        pool_submit(&group, &tasks[i]);
+    }
+    pool_wait(&group);
+}
+
+/* every thread works its own node's range first, then helps the others */
+static void node_task(void *arg, size_t index)
+{
+    int i, k, node = current_node();
+    size_t begin, end, last, bytes;
+    double start;
+    struct nodejob_s *job = arg;
+    (void)index;
+
+    for(i = 0; i < pool.num_nodes; i++) {
+        k = (node + i) % pool.num_nodes;
+        last = (size_t)(k + 1) * job->count / (size_t)pool.num_nodes;
+        bytes = 0;
+        start = now_seconds();
+        while((begin = (size_t)atom_add(&job->next[k], NODE_GRAIN) - NODE_GRAIN) < last) {
+            end = begin + NODE_GRAIN < last ? begin + NODE_GRAIN : last;
+            job->func(job->arg, begin, end);
+            bytes += (end - begin) * job->item_bytes;
+        }
+
+        if(bytes) {
+            mutex_lock(&job->lock);
+            job->node_threads[k]++;
+            job->node_time[k] += now_seconds() - start;
+            job->node_bytes[k] += bytes;
+            mutex_unlock(&job->lock);
+        }
+    }
+}
+
+/* calls func over [0, count) so that each node keeps working on the same
+ * slice of the items; arrays first touched this way stay node-local */
+static void pool_for_nodes(struct nodejob_s *job, size_t count, size_t item_bytes, void (*func)(void *arg, size_t begin, size_t end), void *arg)
+{
+    int k;
+    size_t i, tasks = (size_t)pool_width();
+    struct task_s task[MAX_WORKERS];
+    struct taskgroup_s group = { 0 };
+
+    memset(job, 0, sizeof(struct nodejob_s));
+    job->func = func;
+    job->arg = arg;
+    job->count = count;
+    job->item_bytes = item_bytes;
+    for(k = 0; k < pool.num_nodes; k++)
+        job->next[k] = (atom_t)((size_t)k * count / (size_t)pool.num_nodes);
+    mutex_init(&job->lock);
+
+    for(i = 0; i < tasks; i++) {
+        task[i].func = &node_task;
+        task[i].arg = job;
+        task[i].index = i;
+        pool_submit(&group, &task[i]);
+    }
+    pool_wait(&group);
+
+    mutex_destroy(&job->lock);
+}
+
+static void print_node_stats(const char *label, const struct nodejob_s *job)
+{
+    int k;
+    for(k = 0; k < pool.num_nodes; k++) {
+        lprintf("%s: node %d: %.1f MiB, %.1f MiB/s on %d thread(s)\n", label, k, (double)job->node_bytes[k] / 1048576.0,
+            (double)job->node_bytes[k] / 1048576.0 / (job->node_time[k] > 0.0 ? job->node_time[k] : 1e-9) * job->node_threads[k],
+            job->node_threads[k]);
+    }
+}
+
+static void print_pool_stats(void)
+{
+    int i;
+    size_t executed = 0, steals = 0;
+
+    for(i = 0; i <= pool.num_workers; i++) {
+        executed += pool.deques[i].executed;
+        steals += pool.deques[i].steals;
+    }
+
+    lprintf("pool: %d thread(s) on %d node(s), %zu task(s), %zu steal(s)\n", pool_width(), pool.num_nodes, executed, steals);
+    for(i = 0; i <= pool.num_workers; i++)
+        lprintf("pool: [%d] %zu task(s), %zu steal(s)\n", i, pool.deques[i].executed, pool.deques[i].steals);
+}
+
+/* large linearly scanned arrays; huge pages cut down on TLB misses */
+static void *big_alloc(size_t size)
+{
+    void *ptr;
+#if defined(__linux__)
+    size_t len, head;
+    unsigned char *map;
+#endif
+
+    atom_add(&heap_allocs, 1);
+#if defined(__linux__)
+
+    if(size >= HUGE_PAGE_SIZE) {
+        len = (size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+#if UNDGRAPH_USE_HUGETLB
+        ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(ptr != MAP_FAILED)
+            return ptr;
+#endif
+        /* transparent huge pages only back aligned ranges */
+        map = mmap(NULL, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        assert(("Out of memory!", map != MAP_FAILED));
+        head = (HUGE_PAGE_SIZE - ((uintptr_t)map & (HUGE_PAGE_SIZE - 1))) & (HUGE_PAGE_SIZE - 1);
+        if(head)
+            munmap(map, head);
+        munmap(map + head + len, HUGE_PAGE_SIZE - head);
+#if defined(MADV_HUGEPAGE)
+        madvise(map + head, len, MADV_HUGEPAGE);
+#endif
+        return map + head;
+    }
+#endif
+
+    ptr = malloc(size ? size : 1);
+    assert(("Out of memory!", ptr));
+    return ptr;
+}
+
+static void big_free(void *ptr, size_t size)
+{
+#if defined(__linux__)
+    if(ptr && size >= HUGE_PAGE_SIZE) {
+        munmap(ptr, (size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1));
+        return;
+    }
+#endif
+    (void)size;
+    free(ptr);
+}
+
+static void arena_init(struct arena_s *arena)
+{
+    memset(arena, 0, sizeof(struct arena_s));
+    mutex_init(&arena->lock);
+}
+
+static struct arenachunk_s *new_arena_chunk(size_t size)
+{
+    struct arenachunk_s *chunk = big_alloc(ARENA_HEADER + size);
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+static void *arena_alloc_aligned(struct arena_s *arena, size_t size, size_t align)
+{
+    uintptr_t base = 0, ptr = 0;
+    size_t need;
+    struct arenachunk_s *chunk;
+
+    mutex_lock(&arena->lock);
+
+    chunk = arena->chunks;
+    if(chunk) {
+        base = (uintptr_t)chunk + ARENA_HEADER;
+        ptr = (base + chunk->used + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+    /* grow geometrically so a reset can fold everything into one chunk */
+    if(!chunk || ptr + size > base + chunk->size) {
+        need = size + align;
+        if(need < arena->capacity)
+            need = arena->capacity;
+        if(need < ARENA_MIN_CHUNK)
+            need = ARENA_MIN_CHUNK;
+        chunk = new_arena_chunk(need);
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->capacity += need;
+        base = (uintptr_t)chunk + ARENA_HEADER;
+        ptr = (base + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+    arena->last = (void *)ptr;
+    arena->last_used = chunk->used;
+    chunk->used = (size_t)(ptr + size - base);
+
+    mutex_unlock(&arena->lock);
+    return (void *)ptr;
+}
+
+static void *arena_alloc(struct arena_s *arena, size_t size)
+{
+    return arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+}
+
+/* only the most recent allocation can actually be given back */
+static void arena_free(struct arena_s *arena, void *ptr)
+{
+    mutex_lock(&arena->lock);
+    if(ptr && ptr == arena->last) {
+        arena->chunks->used = arena->last_used;
+        arena->last = NULL;
+    }
+    mutex_unlock(&arena->lock);
+}
+
+static void *arena_realloc(struct arena_s *arena, void *ptr, size_t old_size, size_t new_size)
+{
+    void *grown;
+    uintptr_t base;
+
+    if(!ptr)
+        return arena_alloc(arena, new_size);
+
+    /* the most recent allocation grows in place */
+    mutex_lock(&arena->lock);
+    if(ptr == arena->last) {
+        base = (uintptr_t)arena->chunks + ARENA_HEADER;
+        if((uintptr_t)ptr + new_size <= base + arena->chunks->size) {
+            arena->chunks->used = (size_t)((uintptr_t)ptr + new_size - base);
+            mutex_unlock(&arena->lock);
+            return ptr;
+        }
+    }
+    mutex_unlock(&arena->lock);
+
+    grown = arena_alloc(arena, new_size);
+    memcpy(grown, ptr, old_size < new_size ? old_size : new_size);
+    return grown;
+}
+
+/* the end of an allocation that will not grow again; whole pages past
+ * the new end go back to the system, returns how many bytes that was */
+static size_t arena_shrink(struct arena_s *arena, void *ptr, size_t old_size, size_t new_size)
+{
+    size_t released = 0;
+#if defined(__linux__)
+    uintptr_t lo, hi, page = (uintptr_t)sysconf(_SC_PAGESIZE);
+#endif
+
+    mutex_lock(&arena->lock);
+    if(ptr == arena->last)
+        arena->chunks->used -= old_size - new_size;
+#if defined(__linux__)
+    /* under the lock, so nothing new lands in the range first */
+    lo = ((uintptr_t)ptr + new_size + page - 1) & ~(page - 1);
+    hi = ((uintptr_t)ptr + old_size) & ~(page - 1);
+    if(hi > lo && !madvise((void *)lo, hi - lo, MADV_DONTNEED))
+        released = hi - lo;
+#endif
+    mutex_unlock(&arena->lock);
+    return released;
+}
+
+static void arena_reset(struct arena_s *arena)
+{
+    struct arenachunk_s *chunk, *next;
+
+    mutex_lock(&arena->lock);
+    if(arena->chunks && arena->chunks->next) {
+        for(chunk = arena->chunks; chunk; chunk = next) {
+            next = chunk->next;
+            big_free(chunk, ARENA_HEADER + chunk->size);
+        }
+        arena->chunks = new_arena_chunk(arena->capacity);
+    }
+    if(arena->chunks)
+        arena->chunks->used = 0;
+    arena->last = NULL;
+    mutex_unlock(&arena->lock);
+}
+
+static void arena_destroy(struct arena_s *arena)
+{
+    struct arenachunk_s *chunk, *next;
+    for(chunk = arena->chunks; chunk; chunk = next) {
+        next = chunk->next;
+        big_free(chunk, ARENA_HEADER + chunk->size);
+    }
+    mutex_destroy(&arena->lock);
+    memset(arena, 0, sizeof(struct arena_s));
+}
+
+#if !UNDGRAPH_HAVE_ZLIB
+/* whoever encodes sets stbiw_arena first */
+static void *stbiw_malloc(size_t size)
+{
+    return arena_alloc(stbiw_arena, size);
+}
+
+static void *stbiw_realloc(void *ptr, size_t old_size, size_t new_size)
+{
+    return arena_realloc(stbiw_arena, ptr, old_size, new_size);
+}
+
+static void stbiw_free(void *ptr)
+{
+    arena_free(stbiw_arena, ptr);
+}
+#else
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+    return arena_alloc(opaque, (size_t)items * size);
+}
+
+static void zlib_free(voidpf opaque, voidpf ptr)
+{
+    arena_free(opaque, ptr);
+}
+#endif
+
+#if UNDGRAPH_HAVE_ZSTD
+static void *zstd_alloc(void *opaque, size_t size)
+{
+    return arena_alloc(opaque, size);
+}
+
+static void zstd_free(void *opaque, void *ptr)
+{
+    arena_free(opaque, ptr);
+}
+#endif
+
+struct bitwriter_s {
+    unsigned char *buf;
+    size_t len;
+    uint64_t acc;
+    int nacc;
+};
+
+struct bitreader_s {
+    const unsigned char *buf;
+    const unsigned char *end;
+    uint64_t acc;
+    int nacc;
+};
+
+static void put_bits(struct bitwriter_s *bw, uint32_t value, int n)
+{
+    bw->acc = (bw->acc << n) | (value & (uint32_t)(((uint64_t)1 << n) - 1));
+    bw->nacc += n;
+    while(bw->nacc >= 8) {
+        bw->nacc -= 8;
+        bw->buf[bw->len++] = (unsigned char)(bw->acc >> bw->nacc);
+    }
+}
+
+static size_t flush_bits(struct bitwriter_s *bw)
+{
+    if(bw->nacc > 0)
+        bw->buf[bw->len++] = (unsigned char)(bw->acc << (8 - bw->nacc));
+    bw->nacc = 0;
+    return bw->len;
+}
+
+static uint32_t get_bits(struct bitreader_s *br, int n)
+{
+    while(br->nacc < n) {
+        br->acc = (br->acc << 8) | (br->buf < br->end ? *br->buf++ : 0);
+        br->nacc += 8;
+    }
+    br->nacc -= n;
+    return (uint32_t)(br->acc >> br->nacc) & (uint32_t)(((uint64_t)1 << n) - 1);
+}
+
+/* zigzag value, bucketed like the gorilla timestamp encoding */
+static void put_packed(struct bitwriter_s *bw, int32_t value)
+{
+    uint32_t u = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    if(u == 0) {
+        put_bits(bw, 0, 1);
+    }
+    else if(u < 128) {
+        put_bits(bw, 2, 2);
+        put_bits(bw, u, 7);
+    }
+    else if(u < 512) {
+        put_bits(bw, 6, 3);
+        put_bits(bw, u, 9);
+    }
+    else if(u < 4096) {
+        put_bits(bw, 14, 4);
+        put_bits(bw, u, 12);
+    }
+    else {
+        put_bits(bw, 15, 4);
+        put_bits(bw, u, 32);
+    }
+}
+
+static int32_t get_packed(struct bitreader_s *br)
+{
+    uint32_t u;
+    if(!get_bits(br, 1))
+        return 0;
+    if(!get_bits(br, 1))
+        u = get_bits(br, 7);
+    else if(!get_bits(br, 1))
+        u = get_bits(br, 9);
+    else if(!get_bits(br, 1))
+        u = get_bits(br, 12);
+    else
+        u = get_bits(br, 32);
+    return (int32_t)((u >> 1) ^ (0 - (u & 1)));
+}
+
+static uint32_t float_bits(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static float bits_float(uint32_t u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static int count_leading_zeros(uint32_t x)
+{
+    int n = 0;
+    while(!(x & 0x80000000U)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+}
+
+static int count_trailing_zeros(uint32_t x)
+{
+    int n = 0;
+    while(!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static int count_bits(uint32_t x)
+{
+    int n = 0;
+    for(; x; x &= x - 1)
+        n++;
+    return n;
+}
+
+static int is_integer_block(const float *values, size_t count)
+{
+    size_t i;
+    for(i = 0; i < count; i++) {
+        if(!(fabsf(values[i]) <= 16777216.0f) || values[i] != (float)(int32_t)values[i])
+            return 0;
+    }
+    return 1;
+}
+
+/* worst case of every codec: 4 + 45 bits per value */
+static size_t max_encoded_size(size_t count)
+{
+    return count * 6 + 8;
+}
+
+static size_t encode_block(const float *values, size_t count, int codec, unsigned char *out)
+{
+    size_t i;
+    int32_t prev, delta, prev_delta;
+    uint32_t x, prev_bits;
+    int lead, trail, prev_lead, prev_trail;
+    struct bitwriter_s bw = { 0 };
+
+    bw.buf = out;
+    switch(codec) {
+        case CODEC_DELTA:
+        case CODEC_DOD:
+            prev = (int32_t)values[0];
+            prev_delta = 0;
+            put_bits(&bw, (uint32_t)prev, 32);
+            for(i = 1; i < count; i++) {
+                delta = (int32_t)values[i] - prev;
+                put_packed(&bw, (codec == CODEC_DOD && i > 1) ? delta - prev_delta : delta);
+                prev = (int32_t)values[i];
+                prev_delta = delta;
+            }
+            return flush_bits(&bw);
+
+        case CODEC_XOR:
+            prev_bits = float_bits(values[0]);
+            prev_lead = prev_trail = -1;
+            put_bits(&bw, prev_bits, 32);
+            for(i = 1; i < count; i++) {
+                x = float_bits(values[i]) ^ prev_bits;
+                prev_bits ^= x;
+                if(!x) {
+                    put_bits(&bw, 0, 1);
+                    continue;
+                }
+
+                lead = count_leading_zeros(x);
+                trail = count_trailing_zeros(x);
+                if(prev_lead >= 0 && lead >= prev_lead && trail >= prev_trail) {
+                    put_bits(&bw, 2, 2);
+                    put_bits(&bw, x >> prev_trail, 32 - prev_lead - prev_trail);
+                    continue;
+                }
+
+                put_bits(&bw, 3, 2);
+                put_bits(&bw, (uint32_t)lead, 5);
+                put_bits(&bw, (uint32_t)(31 - lead - trail), 5);
+                put_bits(&bw, x >> trail, 32 - lead - trail);
+                prev_lead = lead;
+                prev_trail = trail;
+            }
+            return flush_bits(&bw);
+
+        default:
+            memcpy(out, values, sizeof(float) * count);
+            return sizeof(float) * count;
+    }
+}
+
+static void prefix_sum(int32_t *v, size_t n)
+{
+    size_t i = 0;
+    int32_t s = 0;
+#if UNDGRAPH_SSE2
+    __m128i x, carry = _mm_setzero_si128();
+    for(; i + 4 <= n; i += 4) {
+        x = _mm_loadu_si128((const __m128i *)(v + i));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        _mm_storeu_si128((__m128i *)(v + i), x);
+        carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    if(i)
+        s = v[i - 1];
+#endif
+    for(; i < n; i++)
+        v[i] = s += v[i];
+}
+
+static void decode_block(const unsigned char *in, size_t nbytes, int codec, size_t count, float *out)
+{
+    size_t i = 0;
+    uint32_t x;
+    int lead, trail;
+    int32_t ints[SAMPLES_PER_BLOCK];
+    struct bitreader_s br = { 0 };
+
+    br.buf = in;
+    br.end = in + nbytes;
+    switch(codec) {
+        case CODEC_DELTA:
+        case CODEC_DOD:
+            ints[0] = (int32_t)get_bits(&br, 32);
+            for(i = 1; i < count; i++)
+                ints[i] = get_packed(&br);
+            if(codec == CODEC_DOD && count > 1)
+                prefix_sum(ints + 1, count - 1);
+            prefix_sum(ints, count);
+            i = 0;
+#if UNDGRAPH_SSE2
+            for(; i + 4 <= count; i += 4)
+                _mm_storeu_ps(out + i, _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(ints + i))));
+#endif
+            for(; i < count; i++)
+                out[i] = (float)ints[i];
+            break;
+
+        case CODEC_XOR:
+            x = get_bits(&br, 32);
+            out[0] = bits_float(x);
+            lead = trail = 0;
+            for(i = 1; i < count; i++) {
+                if(get_bits(&br, 1)) {
+                    if(get_bits(&br, 1)) {
+                        lead = (int)get_bits(&br, 5);
+                        trail = 31 - lead - (int)get_bits(&br, 5);
+                    }
+                    x ^= get_bits(&br, 32 - lead - trail) << trail;
+                }
+                out[i] = bits_float(x);
+            }
+            break;
+
+        default:
+            i = sizeof(float) * count < nbytes ? sizeof(float) * count : nbytes;
+            memcpy(out, in, i);
+            memset((unsigned char *)out + i, 0, sizeof(float) * count - i);
+            break;
+    }
+}
+
+static size_t count_blocks(const struct graphdata_s *data)
+{
+    return (data->size + SAMPLES_PER_BLOCK - 1) / SAMPLES_PER_BLOCK;
+}
+
+/* returns the values of a block, decoding it into scratch if needed */
+static const float *get_block(const struct graphdata_s *data, size_t block, float *scratch, size_t *count)
+{
+    const struct sampleblock_s *sb;
+
+    if(data->data) {
+        *count = data->size - block * SAMPLES_PER_BLOCK;
+        if(*count > SAMPLES_PER_BLOCK)
+            *count = SAMPLES_PER_BLOCK;
+        return data->data + block * SAMPLES_PER_BLOCK;
+    }
+
+    sb = &data->store.blocks[block];
+    *count = sb->count;
+    decode_block(data->store.bytes + sb->offset, sb->nbytes, sb->codec, sb->count, scratch);
+    return scratch;
+}
+
+/* fills in the block's zone map and picks whichever codec packs it the
+ * tightest; buffers holds two encodings side by side and the best one
+ * is returned */
+static const unsigned char *choose_codec(const float *values, struct sampleblock_s *sb, unsigned char *buffers)
+{
+    int codec;
+    size_t j, n;
+    unsigned char *best = buffers, *trial = buffers + max_encoded_size(SAMPLES_PER_BLOCK), *tmp;
+
+    sb->min_value = FLT_MAX;
+    sb->max_value = -FLT_MAX;
+    for(j = 0; j < sb->count; j++) {
+        if(values[j] < sb->min_value)
+            sb->min_value = values[j];
+        if(values[j] > sb->max_value)
+            sb->max_value = values[j];
+    }
+
+    sb->codec = CODEC_RAW;
+    sb->nbytes = sizeof(float) * sb->count;
+    for(codec = CODEC_DELTA; codec <= CODEC_XOR; codec++) {
+        if(codec != CODEC_XOR && !is_integer_block(values, sb->count))
+            continue;
+        n = encode_block(values, sb->count, codec, trial);
+        if(n < sb->nbytes) {
+            sb->nbytes = n;
+            sb->codec = codec;
+            tmp = best;
+            best = trial;
+            trial = tmp;
+        }
+    }
+
+    if(sb->codec == CODEC_RAW)
+        encode_block(values, sb->count, CODEC_RAW, best);
+    return best;
+}
+
+/* saved is what the samples no longer hold resident */
+static void print_store(const struct graphdata_s *data, size_t saved)
+{
+    lprintf("store: %zu blocks, %zu bytes (%.2fx), %.1f MiB saved\n", data->store.num_blocks, data->store.nbytes,
+        (double)(sizeof(float) * data->size) / (double)(data->store.nbytes ? data->store.nbytes : 1), (double)saved / 1048576.0);
+}
+
+static void compress_samples(struct graphdata_s *data)
+{
+    size_t i, released;
+    unsigned char *buffers;
+    const unsigned char *best;
+    struct sampleblock_s *sb;
+    struct samplestore_s *store = &data->store;
+
+    /* no block is ever stored larger than raw, so the encoded blocks are
+     * packed down over the samples they replace and never overtake the
+     * block being read */
+    store->num_blocks = count_blocks(data);
+    store->blocks = arena_alloc(data->arena, sizeof(struct sampleblock_s) * store->num_blocks);
+    store->bytes = (unsigned char *)data->data;
+    buffers = arena_alloc(data->arena, 2 * max_encoded_size(SAMPLES_PER_BLOCK));
+
+    store->nbytes = 0;
+    for(i = 0; i < store->num_blocks; i++) {
+        sb = &store->blocks[i];
+        sb->count = data->size - i * SAMPLES_PER_BLOCK;
+        if(sb->count > SAMPLES_PER_BLOCK)
+            sb->count = SAMPLES_PER_BLOCK;
+        best = choose_codec(data->data + i * SAMPLES_PER_BLOCK, sb, buffers);
+        sb->offset = store->nbytes;
+        memmove(store->bytes + store->nbytes, best, sb->nbytes);
+        store->nbytes += sb->nbytes;
+    }
+
+    arena_free(data->arena, buffers);
+
+    /* the rest of the sample array goes back */
+    released = arena_shrink(data->arena, store->bytes, sizeof(float) * data->size, store->nbytes);
+    print_store(data, released);
+    data->data = NULL;
+}
+
+/* the memory itself goes back with the file arena */
+static void free_samples(struct graphdata_s *data)
+{
+    data->data = NULL;
+    data->store.blocks = NULL;
+    data->store.bytes = NULL;
+    data->store.num_blocks = 0;
+    data->store.nbytes = 0;
+}
+
+static int seek_file(FILE *fp, uint64_t offset)
+{
+#if defined(_MSC_VER)
+    return _fseeki64(fp, (__int64)offset, SEEK_SET);
+#else
+    return fseeko(fp, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static void write_u32(FILE *fp, uint32_t value)
+{
+    unsigned char b[4];
+    b[0] = (unsigned char)(value);
+    b[1] = (unsigned char)(value >> 8);
+    b[2] = (unsigned char)(value >> 16);
+    b[3] = (unsigned char)(value >> 24);
+    fwrite(b, 1, sizeof(b), fp);
+}
+
+static void write_u64(FILE *fp, uint64_t value)
+{
+    write_u32(fp, (uint32_t)value);
+    write_u32(fp, (uint32_t)(value >> 32));
+}
+
+static uint32_t read_u32(FILE *fp)
+{
+    unsigned char b[4] = { 0 };
+    if(fread(b, 1, sizeof(b), fp) != sizeof(b))
+        return 0;
+    return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+static uint64_t read_u64(FILE *fp)
+{
+    uint64_t lo = read_u32(fp);
+    return lo | (uint64_t)read_u32(fp) << 32;
+}
+
+/*
+ * Block file layout (little endian):
+ *  magic, version, tags, min, max, sample count, block count
+ *  block index: offset, nbytes, count, codec, min, max per block
+ *  block payloads, encoded like the in-memory sample store
+ */
+static int write_undgraph_blocks(const char *filename, const struct graphdata_s *data)
+{
+    size_t i, j, count, nbytes;
+    uint64_t offset;
+    float *scratch;
+    const float *values;
+    unsigned char *payload;
+    const struct sampleblock_s *sb;
+    float block_min, block_max;
+    FILE *fp;
+
+    fp = fopen(filename, "wb");
+    if(!fp) {
+        lprintf("%s: %s\n", filename, strerror(errno));
+        return 0;
+    }
+
+    fwrite(BLOCKFILE_MAGIC, 1, 8, fp);
+    write_u32(fp, BLOCKFILE_VERSION);
+    write_u32(fp, (uint32_t)data->msaa);
+    write_u32(fp, (uint32_t)data->save);
+    write_u32(fp, (uint32_t)data->compress);
+    write_u32(fp, float_bits(data->line_width));
+    write_u32(fp, float_bits(data->frame_px));
+    write_u32(fp, float_bits(data->min_value));
+    write_u32(fp, float_bits(data->max_value));
+    write_u64(fp, data->size);
+    write_u64(fp, count_blocks(data));
+
+    /* index */
+    offset = BLOCKFILE_HEADER_SIZE + BLOCKFILE_ENTRY_SIZE * (uint64_t)count_blocks(data);
+    for(i = 0; i < count_blocks(data); i++) {
+        if(data->data) {
+            count = data->size - i * SAMPLES_PER_BLOCK;
+            if(count > SAMPLES_PER_BLOCK)
+                count = SAMPLES_PER_BLOCK;
+            values = data->data + i * SAMPLES_PER_BLOCK;
+            block_min = FLT_MAX;
+            block_max = -FLT_MAX;
+            for(j = 0; j < count; j++) {
+                if(values[j] < block_min)
+                    block_min = values[j];
+                if(values[j] > block_max)
+                    block_max = values[j];
+            }
+            write_u64(fp, offset);
+            write_u64(fp, sizeof(float) * count);
+            write_u32(fp, (uint32_t)count);
+            write_u32(fp, CODEC_RAW);
+            write_u32(fp, float_bits(block_min));
+            write_u32(fp, float_bits(block_max));
+            offset += sizeof(float) * count;
+            continue;
+        }
+
+        sb = &data->store.blocks[i];
+        write_u64(fp, offset);
+        write_u64(fp, sb->nbytes);
+        write_u32(fp, (uint32_t)sb->count);
+        write_u32(fp, (uint32_t)sb->codec);
+        write_u32(fp, float_bits(sb->min_value));
+        write_u32(fp, float_bits(sb->max_value));
+        offset += sb->nbytes;
+    }
+
+    /* payloads */
+    scratch = arena_alloc(data->arena, sizeof(float) * SAMPLES_PER_BLOCK);
+    payload = arena_alloc(data->arena, sizeof(float) * SAMPLES_PER_BLOCK);
+    for(i = 0; i < count_blocks(data); i++) {
+        if(data->data) {
+            values = get_block(data, i, scratch, &count);
+            nbytes = encode_block(values, count, CODEC_RAW, payload);
+            fwrite(payload, 1, nbytes, fp);
+            continue;
+        }
+
+        sb = &data->store.blocks[i];
+        fwrite(data->store.bytes + sb->offset, 1, sb->nbytes, fp);
+    }
+
+    arena_free(data->arena, payload);
+    arena_free(data->arena, scratch);
+
+    if(ferror(fp)) {
+        lprintf("%s: write error\n", filename);
+        fclose(fp);
+        return 0;
+    }
+
+    fclose(fp);
+    lprintf("%s: wrote %zu values in %zu blocks\n", filename, data->size, count_blocks(data));
+    return 1;
+}
+
+static int read_undgraph_blocks(const char *filename, FILE *fp, struct graphdata_s *data)
+{
+    size_t i, g, first, last, begin, end, total, num_blocks, lo, hi, stride, seen;
+    uint32_t codec;
+    struct sampleblock_s *index;
+    unsigned char *payload;
+    float *scratch;
+    int whole;
+
+    if(read_u32(fp) != BLOCKFILE_VERSION) {
+        lprintf("%s: unsupported block file version\n", filename);
+        return 0;
+    }
+
+    data->msaa = (int)read_u32(fp);
+    data->save = (int)read_u32(fp);
+    data->compress = (int)read_u32(fp);
+    data->line_width = bits_float(read_u32(fp));
+    data->frame_px = bits_float(read_u32(fp));
+    data->min_value = bits_float(read_u32(fp));
+    data->max_value = bits_float(read_u32(fp));
+    total = (size_t)read_u64(fp);
+    num_blocks = (size_t)read_u64(fp);
+    if(num_blocks != (total + SAMPLES_PER_BLOCK - 1) / SAMPLES_PER_BLOCK) {
+        lprintf("%s: corrupt block index\n", filename);
+        return 0;
+    }
+
+    /* every block but the last is full, the counts add up to the total
+     * and raw blocks hold exactly their samples, so nothing decodes past
+     * what was read */
+    index = arena_alloc(data->arena, sizeof(struct sampleblock_s) * num_blocks);
+    for(i = 0, seen = 0; i < num_blocks; i++) {
+        index[i].offset = (size_t)read_u64(fp);
+        index[i].nbytes = (size_t)read_u64(fp);
+        index[i].count = read_u32(fp);
+        codec = read_u32(fp);
+        index[i].codec = (int)codec;
+        index[i].min_value = bits_float(read_u32(fp));
+        index[i].max_value = bits_float(read_u32(fp));
+        seen += index[i].count;
+        if(index[i].count > SAMPLES_PER_BLOCK || index[i].nbytes > max_encoded_size(SAMPLES_PER_BLOCK) ||
+           codec > CODEC_XOR || (codec == CODEC_RAW && index[i].nbytes != sizeof(float) * index[i].count) ||
+           (i + 1 < num_blocks && index[i].count != SAMPLES_PER_BLOCK)) {
+            lprintf("%s: corrupt block index\n", filename);
+            return 0;
+        }
+    }
+    if(seen != total) {
+        lprintf("%s: corrupt block index\n", filename);
+        return 0;
+    }
+
+    /* clamp the requested range */
+    begin = data->range_begin < total ? data->range_begin : total;
+    end = (data->range_end && data->range_end < total) ? data->range_end : total;
+    if(end < begin)
+        end = begin;
+    stride = data->stride > 1 ? data->stride : 1;
+    data->size = (end - begin + stride - 1) / stride;
+    whole = (begin == 0 && end == total && stride == 1);
+    lprintf("%s: found %zu values in %zu blocks\n", filename, total, num_blocks);
+
+    if(!data->size) {
+        data->data = arena_alloc(data->arena, 0);
+        return 1;
+    }
+
+    /* compressed blocks can go straight into the sample store */
+    if(whole && data->compress) {
+        for(i = 0, lo = 0; i < num_blocks; i++)
+            lo += index[i].nbytes;
+        payload = arena_alloc(data->arena, lo);
+        for(i = 0, lo = 0; i < num_blocks; i++) {
+            seek_file(fp, index[i].offset);
+            if(fread(payload + lo, 1, index[i].nbytes, fp) != index[i].nbytes)
+                goto truncated;
+            index[i].offset = lo;
+            lo += index[i].nbytes;
+        }
+        data->store.num_blocks = num_blocks;
+        data->store.blocks = index;
+        data->store.nbytes = lo;
+        data->store.bytes = payload;
+        return 1;
+    }
+
+    data->data = arena_alloc(data->arena, sizeof(float) * data->size);
+    scratch = arena_alloc(data->arena, sizeof(float) * SAMPLES_PER_BLOCK);
+    payload = arena_alloc(data->arena, max_encoded_size(SAMPLES_PER_BLOCK));
+
+    /* only the blocks overlapping the range are read */
+    first = begin / SAMPLES_PER_BLOCK;
+    last = (end - 1) / SAMPLES_PER_BLOCK;
+    if(!whole) {
+        data->min_value = FLT_MAX;
+        data->max_value = -FLT_MAX;
+    }
+
+    for(i = first; i <= last; i++) {
+        lo = (i == first) ? begin - i * SAMPLES_PER_BLOCK : 0;
+        hi = (i == last) ? end - i * SAMPLES_PER_BLOCK : index[i].count;
+
+        /* blocks that fall between two strided samples are not read */
+        g = i * SAMPLES_PER_BLOCK + lo;
+        g = begin + (g - begin + stride - 1) / stride * stride;
+        if(g >= i * SAMPLES_PER_BLOCK + hi)
+            continue;
+
+        seek_file(fp, index[i].offset);
+        if(fread(payload, 1, index[i].nbytes, fp) != index[i].nbytes)
+            goto truncated;
+
+        decode_block(payload, index[i].nbytes, index[i].codec, index[i].count, scratch);
+        if(stride > 1) {
+            for(; g < i * SAMPLES_PER_BLOCK + hi; g += stride) {
+                lo = g - i * SAMPLES_PER_BLOCK;
+                data->data[(g - begin) / stride] = scratch[lo];
+                if(scratch[lo] < data->min_value)
+                    data->min_value = scratch[lo];
+                if(scratch[lo] > data->max_value)
+                    data->max_value = scratch[lo];
+            }
+            continue;
+        }
+
+        memcpy(data->data + (i * SAMPLES_PER_BLOCK + lo - begin), scratch + lo, sizeof(float) * (hi - lo));
+        if(whole)
+            continue;
+
+        /* zone maps cover whole blocks, partial ones get scanned */
+        if(lo == 0 && hi == index[i].count) {
+            if(index[i].min_value < data->min_value)
+                data->min_value = index[i].min_value;
+            if(index[i].max_value > data->max_value)
+                data->max_value = index[i].max_value;
+            continue;
+        }
+
+        for(; lo < hi; lo++) {
+            if(scratch[lo] < data->min_value)
+                data->min_value = scratch[lo];
+            if(scratch[lo] > data->max_value)
+                data->max_value = scratch[lo];
+        }
+    }
+
+    arena_free(data->arena, payload);
+    return 1;
+
+truncated:
+    lprintf("%s: truncated block file\n", filename);
+    data->data = NULL;
+    return 0;
+}
+
+#if UNDGRAPH_HAVE_IO_URING
+static int uring_init(struct ioreader_s *io)
+{
+    struct io_uring_params p;
+    unsigned char *sq, *cq;
+
+    memset(&p, 0, sizeof(p));
+    io->ring_fd = (int)syscall(__NR_io_uring_setup, IO_DEPTH, &p);
+    if(io->ring_fd < 0)
+        return 0;
+
+    io->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    io->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if(p.features & IORING_FEAT_SINGLE_MMAP) {
+        if(io->cq_size > io->sq_size)
+            io->sq_size = io->cq_size;
+        io->cq_size = 0;
+    }
+
+    io->sq_ring = mmap(NULL, io->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring_fd, IORING_OFF_SQ_RING);
+    io->cq_ring = io->cq_size ? mmap(NULL, io->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring_fd, IORING_OFF_CQ_RING) : io->sq_ring;
+    io->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring_fd, IORING_OFF_SQES);
+    if(io->sq_ring == MAP_FAILED || io->cq_ring == MAP_FAILED || io->sqes == MAP_FAILED) {
+        lprintf("io_uring: mmap failed, falling back to pread\n");
+        if(io->sqes != MAP_FAILED)
+            munmap(io->sqes, p.sq_entries * sizeof(struct io_uring_sqe));
+        if(io->cq_size && io->cq_ring != MAP_FAILED)
+            munmap(io->cq_ring, io->cq_size);
+        if(io->sq_ring != MAP_FAILED)
+            munmap(io->sq_ring, io->sq_size);
+        close(io->ring_fd);
+        return 0;
+    }
+
+    sq = io->sq_ring;
+    cq = io->cq_ring;
+    io->num_sqes = p.sq_entries;
+    io->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    io->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    io->sq_array = (unsigned *)(sq + p.sq_off.array);
+    io->cq_head = (unsigned *)(cq + p.cq_off.head);
+    io->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    io->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    io->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 1;
+}
+
+/* waits for one completion and records it against its buffer */
+static void uring_reap(struct ioreader_s *io)
+{
+    unsigned head = *io->cq_head;
+    struct io_uring_cqe *cqe;
+    size_t slot;
+
+    while(head == __atomic_load_n(io->cq_tail, __ATOMIC_ACQUIRE))
+        syscall(__NR_io_uring_enter, io->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+
+    cqe = &io->cqes[head & *io->cq_mask];
+    slot = (size_t)cqe->user_data;
+    io->lens[slot] = cqe->res > 0 ? (size_t)cqe->res : 0;
+    io->ready[slot] = cqe->res >= 0 ? 1 : -1;
+    __atomic_store_n(io->cq_head, head + 1, __ATOMIC_RELEASE);
+    io->inflight--;
+}
+
+static void uring_shutdown(struct ioreader_s *io)
+{
+    /* the kernel may still be writing into the buffers */
+    while(io->inflight)
+        uring_reap(io);
+
+    munmap(io->sqes, io->num_sqes * sizeof(struct io_uring_sqe));
+    if(io->cq_size)
+        munmap(io->cq_ring, io->cq_size);
+    munmap(io->sq_ring, io->sq_size);
+    close(io->ring_fd);
+}
+#endif
+
+/* synchronous fallback, also used to finish short reads */
+static size_t read_at(struct ioreader_s *io, unsigned char *buf, size_t size, uint64_t offset)
+{
+    size_t n = 0;
+#if defined(_WIN32)
+    if(!_fseeki64(io->fp, (__int64)offset, SEEK_SET))
+        n = fread(buf, 1, size, io->fp);
+#else
+    ssize_t r;
+    while(n < size) {
+        r = pread(io->fd, buf + n, size - n, (off_t)(offset + n));
+        if(r < 0 && errno == EINTR)
+            continue;
+        if(r <= 0)
+            break;
+        n += (size_t)r;
+    }
+#endif
+    return n;
+}
+
+static void submit_read(struct ioreader_s *io, size_t slot)
+{
+#if UNDGRAPH_HAVE_IO_URING
+    unsigned tail, index;
+    struct io_uring_sqe *sqe;
+#endif
+
+    io->offsets[slot] = io->offset;
+    io->offset += IO_BUFFER_SIZE;
+    io->ready[slot] = 0;
+
+#if UNDGRAPH_HAVE_IO_URING
+    if(io->uring) {
+        tail = *io->sq_tail;
+        index = tail & *io->sq_mask;
+        sqe = &io->sqes[index];
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = io->fd;
+        sqe->addr = (uint64_t)(uintptr_t)io->bufs[slot];
+        sqe->len = IO_BUFFER_SIZE;
+        sqe->off = io->offsets[slot];
+        sqe->user_data = slot;
+        io->sq_array[index] = index;
+        __atomic_store_n(io->sq_tail, tail + 1, __ATOMIC_RELEASE);
+        if(syscall(__NR_io_uring_enter, io->ring_fd, 1, 0, 0, NULL, 0) == 1) {
+            io->inflight++;
+            return;
+        }
+
+        /* the ring refused the read, stay synchronous from here on */
+        __atomic_store_n(io->sq_tail, tail, __ATOMIC_RELEASE);
+        uring_shutdown(io);
+        io->uring = 0;
+        lprintf("io_uring: submit failed, falling back to pread\n");
+    }
+#endif
+}
+
+static int open_ioreader(struct ioreader_s *io, struct arena_s *arena, FILE *fp, const char *filename, int direct)
+{
+    size_t i;
+
+    memset(io, 0, sizeof(struct ioreader_s));
+    io->arena = arena;
+    io->fp = fp;
+#if !defined(_WIN32)
+    io->fd = fileno(fp);
+
+    /* O_DIRECT needs its own descriptor and aligned buffers */
+#if defined(O_DIRECT)
+    if(direct) {
+        io->fd = open(filename, O_RDONLY | O_DIRECT);
+        io->direct = io->fd >= 0;
+        if(!io->direct) {
+            lprintf("%s: O_DIRECT unavailable: %s\n", filename, strerror(errno));
+            io->fd = fileno(fp);
+        }
+    }
+#endif
+#endif
+    (void)filename;
+    (void)direct;
+
+    for(i = 0; i < IO_DEPTH; i++)
+        io->bufs[i] = arena_alloc_aligned(io->arena, IO_BUFFER_SIZE, IO_ALIGNMENT);
+
+#if UNDGRAPH_HAVE_IO_URING
+    io->uring = uring_init(io);
+#endif
+
+    io->io_start = io->io_end = now_seconds();
+    for(i = 0; i < IO_DEPTH; i++)
+        submit_read(io, i);
+
+    lprintf("%s: reading via %s%s\n", filename, io->uring ? "io_uring" : "pread", io->direct ? " (O_DIRECT)" : "");
+    return 1;
+}
+
+static void close_ioreader(struct ioreader_s *io)
+{
+#if UNDGRAPH_HAVE_IO_URING
+    if(io->uring)
+        uring_shutdown(io);
+#endif
+
+#if !defined(_WIN32)
+    if(io->direct)
+        close(io->fd);
+#endif
+}
+
+/* waits for the next buffer in file order; a zero length means end of file */
+static const unsigned char *next_iobuffer(struct ioreader_s *io, size_t *len)
+{
+    size_t slot = io->head % IO_DEPTH;
+    double start = now_seconds();
+    if(io->eof) {
+        *len = 0;
+        return NULL;
+    }
+
+#if UNDGRAPH_HAVE_IO_URING
+    while(io->uring && !io->ready[slot])
+        uring_reap(io);
+#endif
+
+    if(io->ready[slot] <= 0) {
+        /* synchronous path, or a failed asynchronous read */
+        io->lens[slot] = read_at(io, io->bufs[slot], IO_BUFFER_SIZE, io->offsets[slot]);
+    }
+    else if(io->lens[slot] > 0 && io->lens[slot] < IO_BUFFER_SIZE) {
+        /* short reads are not necessarily the end of the file */
+        io->lens[slot] += read_at(io, io->bufs[slot] + io->lens[slot], IO_BUFFER_SIZE - io->lens[slot], io->offsets[slot] + io->lens[slot]);
+    }
+
+    /* reads finished in the background cost the caller nothing, so the
+     * wait is kept apart from the span the reads took */
+    io->io_end = now_seconds();
+    io->io_wait += io->io_end - start;
+    io->io_bytes += io->lens[slot];
+    *len = io->lens[slot];
+    if(!*len)
+        io->eof = 1;
+    return io->bufs[slot];
+}
+
+/* hands the current buffer back and queues the next read into it */
+static void release_iobuffer(struct ioreader_s *io)
+{
+    size_t slot = io->head++ % IO_DEPTH;
+    if(!io->eof)
+        submit_read(io, slot);
+}
+
+/* drops the queued reads and starts over at offset; O_DIRECT reads start
+ * at the aligned offset below it, so the difference is returned */
+static size_t seek_ioreader(struct ioreader_s *io, uint64_t offset)
+{
+    size_t i;
+    uint64_t aligned = offset & ~(uint64_t)(IO_ALIGNMENT - 1);
+
+#if UNDGRAPH_HAVE_IO_URING
+    while(io->uring && io->inflight)
+        uring_reap(io);
+#endif
+
+    io->offset = aligned;
+    io->head = 0;
+    io->eof = 0;
+    for(i = 0; i < IO_DEPTH; i++)
+        submit_read(io, i);
+    return (size_t)(offset - aligned);
+}
+
+static int open_instream(struct instream_s *in, struct arena_s *arena, FILE *fp, int kind, const char *filename, int direct)
+{
+#if UNDGRAPH_HAVE_ZSTD
+    ZSTD_customMem zmem;
+#endif
+
+    memset(in, 0, sizeof(struct instream_s));
+    in->kind = kind;
+
+    switch(kind) {
+        case INPUT_GZIP:
+#if UNDGRAPH_HAVE_ZLIB
+            in->zs.zalloc = &zlib_alloc;
+            in->zs.zfree = &zlib_free;
+            in->zs.opaque = arena;
+
+            /* 32: accept both zlib and gzip wrappers */
+            if(inflateInit2(&in->zs, 15 + 32) != Z_OK) {
+                lprintf("%s: inflateInit2 failed\n", filename);
+                return 0;
+            }
+            break;
+#else
+            lprintf("%s: gzip input requires zlib support\n", filename);
+            return 0;
+#endif
+
+        case INPUT_ZSTD:
+#if UNDGRAPH_HAVE_ZSTD
+            zmem.customAlloc = &zstd_alloc;
+            zmem.customFree = &zstd_free;
+            zmem.opaque = arena;
+            in->zds = ZSTD_createDStream_advanced(zmem);
+            assert(("Out of memory!", in->zds));
+            ZSTD_initDStream(in->zds);
+            break;
+#else
+            lprintf("%s: zstd input requires zstd support\n", filename);
+            return 0;
+#endif
+    }
+
+    return open_ioreader(&in->io, arena, fp, filename, direct);
+}
+
+/* only plain input can be repositioned */
+static void seek_instream(struct instream_s *in, uint64_t offset)
+{
+    in->inbuf = NULL;
+    in->inpos = 0;
+    in->inlen = 0;
+    in->eof = 0;
+    in->skip = seek_ioreader(&in->io, offset);
+}
+
+static void close_instream(struct instream_s *in)
+{
+#if UNDGRAPH_HAVE_ZLIB
+    if(in->kind == INPUT_GZIP)
+        inflateEnd(&in->zs);
+#endif
+#if UNDGRAPH_HAVE_ZSTD
+    if(in->kind == INPUT_ZSTD)
+        ZSTD_freeDStream(in->zds);
+#endif
+    close_ioreader(&in->io);
+}
+
+/* reads up to size decompressed bytes; short reads only happen at the end */
+static size_t read_instream(struct instream_s *in, char *buf, size_t size)
+{
+    size_t m, n = 0;
+#if UNDGRAPH_HAVE_ZLIB
+    int zr;
+#endif
+#if UNDGRAPH_HAVE_ZSTD
+    ZSTD_inBuffer zin;
+    ZSTD_outBuffer zout;
+    size_t zr2;
+#endif
+
+    while(n < size && !in->eof) {
+        if(in->inpos == in->inlen) {
+            if(in->inbuf)
+                release_iobuffer(&in->io);
+            in->inbuf = next_iobuffer(&in->io, &in->inlen);
+            in->inpos = in->skip < in->inlen ? in->skip : in->inlen;
+            in->skip = 0;
+            if(in->inpos == in->inlen) {
+                in->eof = 1;
+                break;
+            }
+        }
+
+        if(in->kind == INPUT_PLAIN) {
+            m = in->inlen - in->inpos;
+            if(m > size - n)
+                m = size - n;
+            memcpy(buf + n, in->inbuf + in->inpos, m);
+            in->inpos += m;
+            n += m;
+            continue;
+        }
+
+#if UNDGRAPH_HAVE_ZLIB
+        if(in->kind == INPUT_GZIP) {
+            in->zs.next_in = (Bytef *)in->inbuf + in->inpos;
+            in->zs.avail_in = (uInt)(in->inlen - in->inpos);
+            in->zs.next_out = (Bytef *)buf + n;
+            in->zs.avail_out = (uInt)(size - n);
+            zr = inflate(&in->zs, Z_NO_FLUSH);
+            in->inpos = in->inlen - in->zs.avail_in;
+            n = size - in->zs.avail_out;
+            if(zr == Z_STREAM_END) {
+                /* concatenated gzip members */
+                inflateReset(&in->zs);
+            }
+            else if(zr != Z_OK && zr != Z_BUF_ERROR) {
+                lprintf("inflate: %s\n", in->zs.msg ? in->zs.msg : "error");
+                in->eof = 1;
+            }
+        }
+#endif
+#if UNDGRAPH_HAVE_ZSTD
+        if(in->kind == INPUT_ZSTD) {
+            zin.src = in->inbuf;
+            zin.size = in->inlen;
+            zin.pos = in->inpos;
+            zout.dst = buf;
+            zout.size = size;
+            zout.pos = n;
+            zr2 = ZSTD_decompressStream(in->zds, &zout, &zin);
+            in->inpos = zin.pos;
+            n = zout.pos;
+            if(ZSTD_isError(zr2)) {
+                lprintf("zstd: %s\n", ZSTD_getErrorName(zr2));
+                in->eof = 1;
+            }
+        }
+#endif
+    }
+
+    return n;
+}
+
+static size_t count_newlines(const char *p, size_t len)
+{
+    size_t i = 0, n = 0;
+#if UNDGRAPH_SSE2
+    int k;
+    uint64_t sums[2];
+    __m128i acc, total = _mm_setzero_si128();
+    __m128i nl = _mm_set1_epi8('\n');
+
+    /* byte counters overflow after 255 rounds */
+    while(i + 16 <= len) {
+        acc = _mm_setzero_si128();
+        for(k = 0; k < 255 && i + 16 <= len; k++, i += 16)
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), nl));
+        total = _mm_add_epi64(total, _mm_sad_epu8(acc, _mm_setzero_si128()));
+    }
+    _mm_storeu_si128((__m128i *)sums, total);
+    n = (size_t)(sums[0] + sums[1]);
+#endif
+    for(; i < len; i++)
+        n += p[i] == '\n';
+    return n;
+}
+
+/* steps past n newlines without looking at what is between them */
+static char *skip_lines(char *p, const char *last, size_t n)
+{
+#if UNDGRAPH_SSE2
+    int c;
+    uint32_t mask;
+    __m128i nl = _mm_set1_epi8('\n');
+#endif
+
+    if(!n)
+        return p;
+
+#if UNDGRAPH_SSE2
+    while(p + 16 <= last) {
+        mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), nl));
+        c = count_bits(mask);
+        if((size_t)c < n) {
+            n -= (size_t)c;
+            p += 16;
+            continue;
+        }
+        while(--n)
+            mask &= mask - 1;
+        return p + count_trailing_zeros(mask) + 1;
+    }
+#endif
+
+    for(; p < last; p++) {
+        if(*p == '\n' && !--n)
+            return p + 1;
+    }
+    return (char *)last;
+}
+
+static void recycle_chunk(struct pipeline_s *pl, struct chunk_s *chunk)
+{
+    mutex_lock(&pl->lock);
+    pl->spare[pl->num_spare++] = chunk->bytes;
+    chunk->bytes = NULL;
+    mutex_unlock(&pl->lock);
+}
+
+/* cuts the next newline-aligned chunk off the decompressed input */
+static struct chunk_s *read_chunk(struct pipeline_s *pl, char *carry, size_t *carry_len, size_t seq)
+{
+    struct chunk_s *chunk;
+    size_t n, cut;
+
+    chunk = arena_alloc(pl->arena, sizeof(struct chunk_s));
+    memset(chunk, 0, sizeof(struct chunk_s));
+    chunk->pl = pl;
+    chunk->seq = seq;
+
+    /* chunk buffers are recycled once parsed */
+    mutex_lock(&pl->lock);
+    if(pl->num_spare)
+        chunk->bytes = pl->spare[--pl->num_spare];
+    mutex_unlock(&pl->lock);
+    if(!chunk->bytes)
+        chunk->bytes = arena_alloc(pl->arena, CHUNK_SIZE + 1);
+
+    memcpy(chunk->bytes, carry, *carry_len);
+    n = read_instream(pl->in, chunk->bytes + *carry_len, CHUNK_SIZE - *carry_len);
+    chunk->len = *carry_len + n;
+    pl->bytes_in += n;
+
+    /* keep the partial last line for the next chunk */
+    cut = chunk->len;
+    if(chunk->len == CHUNK_SIZE) {
+        while(cut > 0 && chunk->bytes[cut - 1] != '\n')
+            cut--;
+        if(!cut)
+            cut = chunk->len;
+    }
+    *carry_len = chunk->len - cut;
+    memcpy(carry, chunk->bytes + cut, *carry_len);
+    chunk->len = cut;
+
+    /* line numbers are only needed to select or to index */
+    if(pl->select || pl->build_index) {
+        chunk->first_line = pl->line;
+        chunk->lines = count_newlines(chunk->bytes, chunk->len);
+        if(chunk->len && chunk->bytes[chunk->len - 1] != '\n')
+            chunk->lines++;
+        pl->line += chunk->lines;
+    }
+
+    if(pl->build_index && chunk->len) {
+        if(pl->num_marks % 64 == 0)
+            pl->marks = arena_realloc(pl->arena, pl->marks, sizeof(uint64_t) * 2 * pl->num_marks, sizeof(uint64_t) * 2 * (pl->num_marks + 64));
+        pl->marks[2 * pl->num_marks] = chunk->first_line;
+        pl->marks[2 * pl->num_marks + 1] = pl->offset;
+        pl->num_marks++;
+    }
+    pl->offset += chunk->len;
+
+    return chunk;
+}
+
+static void parse_chunk(struct chunk_s *chunk, float *values, struct arena_s *arena)
+{
+    char *p, *end, *next;
+    char *last = chunk->bytes + chunk->len;
+    const struct pipeline_s *pl = chunk->pl;
+    size_t line = chunk->first_line;
+    float f;
+
+    /* strtof must not run off the end of the last line */
+    *last = 0;
+
+    chunk->min_value = FLT_MAX;
+    chunk->max_value = -FLT_MAX;
+
+    /* get onto the first selected line */
+    p = chunk->bytes;
+    if(pl->select) {
+        if(line < pl->begin) {
+            p = skip_lines(p, last, pl->begin - line);
+            line = pl->begin;
+        }
+        else if((line - pl->begin) % pl->stride) {
+            p = skip_lines(p, last, pl->stride - (line - pl->begin) % pl->stride);
+            line += pl->stride - (line - pl->begin) % pl->stride;
+        }
+    }
+
+    for(; p < last && line < pl->end; p = skip_lines(next, last, pl->stride - 1), line += pl->stride) {
+        next = memchr(p, '\n', (size_t)(last - p));
+        next = next ? next + 1 : last;
+
+        while(p < next && (*p == ' ' || *p == '\t'))
+            p++;
+
+        /* same rule as before: the data ends at the first line without a number */
+        if(p == next || *p == '\n' || *p == '\r') {
+            chunk->stop = 1;
+            break;
+        }
+
+        f = strtof(p, &end);
+        if(end == p) {
+            chunk->stop = 1;
+            break;
+        }
+
+        if(f < chunk->min_value)
+            chunk->min_value = f;
+        if(f > chunk->max_value)
+            chunk->max_value = f;
+        values[chunk->count++] = f;
+    }
+
+    chunk->values = arena_alloc(arena, sizeof(float) * chunk->count);
+    memcpy(chunk->values, values, sizeof(float) * chunk->count);
+}
+
+static void parse_task(void *arg, size_t index)
+{
+    struct chunk_s *chunk = arg;
+    struct pipeline_s *pl = chunk->pl;
+    struct chunk_s **grown;
+    size_t cap;
+    double start = now_seconds();
+    (void)index;
+
+    /* scratch belongs to whichever thread runs the task; every value takes at least two bytes */
+    if(!pl->scratch[worker_index])
+        pl->scratch[worker_index] = arena_alloc(pl->arena, sizeof(float) * (CHUNK_SIZE / 2 + 1));
+
+    parse_chunk(chunk, pl->scratch[worker_index], pl->arena);
+    if(chunk->stop)
+        atom_store(&pl->stopped, 1);
+
+    mutex_lock(&pl->lock);
+    pl->parse_time += now_seconds() - start;
+    pl->spare[pl->num_spare++] = chunk->bytes;
+    chunk->bytes = NULL;
+    if(chunk->seq >= pl->num_chunks) {
+        cap = pl->num_chunks ? pl->num_chunks : 64;
+        while(cap <= chunk->seq)
+            cap *= 2;
+        grown = arena_realloc(pl->arena, pl->chunks, sizeof(struct chunk_s *) * pl->num_chunks, sizeof(struct chunk_s *) * cap);
+        memset(grown + pl->num_chunks, 0, sizeof(struct chunk_s *) * (cap - pl->num_chunks));
+        pl->chunks = grown;
+        pl->num_chunks = cap;
+    }
+    pl->chunks[chunk->seq] = chunk;
+    mutex_unlock(&pl->lock);
+
+    atom_add(&pl->outstanding, -1);
+}
+
+/* nan lanes are skipped: minps/maxps return the second operand then */
+static void reduce_minmax(const float *values, size_t count, float *min_value, float *max_value)
+{
+    size_t i = 0;
+    float lo = FLT_MAX, hi = -FLT_MAX;
+#if UNDGRAPH_SSE2
+    float tmp[4];
+    __m128 vlo = _mm_set1_ps(FLT_MAX);
+    __m128 vhi = _mm_set1_ps(-FLT_MAX);
+    for(; i + 4 <= count; i += 4) {
+        vlo = _mm_min_ps(_mm_loadu_ps(values + i), vlo);
+        vhi = _mm_max_ps(_mm_loadu_ps(values + i), vhi);
+    }
+    _mm_storeu_ps(tmp, vlo);
+    lo = tmp[0] < tmp[1] ? tmp[0] : tmp[1];
+    lo = tmp[2] < lo ? tmp[2] : lo;
+    lo = tmp[3] < lo ? tmp[3] : lo;
+    _mm_storeu_ps(tmp, vhi);
+    hi = tmp[0] > tmp[1] ? tmp[0] : tmp[1];
+    hi = tmp[2] > hi ? tmp[2] : hi;
+    hi = tmp[3] > hi ? tmp[3] : hi;
+#endif
+    for(; i < count; i++) {
+        if(values[i] < lo)
+            lo = values[i];
+        if(values[i] > hi)
+            hi = values[i];
+    }
+    *min_value = lo;
+    *max_value = hi;
+}
+
+/* values a scan needs from before its first one */
+static size_t alert_halo(const struct alerts_s *alerts)
+{
+    return (alerts->rules & (1 << RULE_SIGMA)) && alerts->window > 1 ? alerts->window : 1;
+}
+
+static void start_alerts(struct graphdata_s *data)
+{
+    struct alertlist_s *list = &data->alert_list;
+
+    list->runs = arena_alloc(data->arena, sizeof(struct alertrun_s) * MAX_ALERT_RUNS);
+    list->capacity = MAX_ALERT_RUNS;
+    list->count = 0;
+    list->dropped = 0;
+    mutex_init(&list->lock);
+}
+
+/* hands the runs found so far to the shared list; a run cut here gets
+ * joined up again by finish_alerts */
+static void flush_hits(struct alertscan_s *scan)
+{
+    int k;
+    size_t n;
+    struct alertlist_s *list = scan->list;
+
+    mutex_lock(&list->lock);
+    n = list->capacity - list->count < scan->count ? list->capacity - list->count : scan->count;
+    memcpy(list->runs + list->count, scan->runs, sizeof(struct alertrun_s) * n);
+    list->count += n;
+    list->dropped += scan->count - n;
+    mutex_unlock(&list->lock);
+
+    scan->count = 0;
+    for(k = 0; k < NUM_RULES; k++)
+        scan->open[k] = -1;
+}
+
+/* a match of value at index against one rule; metric is what the run
+ * reports as its worst: the value, the step or the z-score */
+static void add_hit(struct alertscan_s *scan, int rule, size_t index, float metric)
+{
+    struct alertrun_s *run;
+
+    if(scan->open[rule] >= 0 && scan->runs[scan->open[rule]].last + 1 == index) {
+        run = scan->runs + scan->open[rule];
+        run->last = index;
+        if(rule == RULE_BELOW ? metric < run->peak : metric > run->peak)
+            run->peak = metric;
+        return;
+    }
+
+    if(scan->count == ALERT_BATCH)
+        flush_hits(scan);
+    run = scan->runs + scan->count;
+    run->rule = rule;
+    run->first = run->last = index;
+    run->peak = metric;
+    scan->open[rule] = (int)scan->count++;
+}
+
+static void init_scan(struct alertscan_s *scan, const struct alerts_s *alerts, struct alertlist_s *list)
+{
+    int k;
+
+    scan->alerts = alerts;
+    scan->list = list;
+    scan->index = 0;
+    scan->count = 0;
+    for(k = 0; k < NUM_RULES; k++)
+        scan->open[k] = -1;
+}
+
+static void check_value(struct alertscan_s *scan, float x, float prev, size_t index)
+{
+    const struct alerts_s *a = scan->alerts;
+    float d = x - prev;
+
+    if((a->rules & (1 << RULE_ABOVE)) && x > a->above)
+        add_hit(scan, RULE_ABOVE, index, x);
+    if((a->rules & (1 << RULE_BELOW)) && x < a->below)
+        add_hit(scan, RULE_BELOW, index, x);
+    if((a->rules & (1 << RULE_SLOPE)) && fabsf(d) > a->slope)
+        add_hit(scan, RULE_SLOPE, index, fabsf(d));
+}
+
+/* deviation from the mean of the window before each value, in standard
+ * deviations of that window; sums are kept relative to the first value
+ * seen so they do not cancel out */
+static void scan_sigma(struct alertscan_s *scan, const float *values, size_t count, const float *history, size_t num_history)
+{
+    size_t i, n = 0, seen, window = scan->alerts->window;
+    double sum = 0.0, sumsq = 0.0, ref = 0.0, mean, var, x;
+    float z, old;
+    int have_ref = 0;
+
+    seen = num_history < window ? num_history : window;
+    for(i = num_history - seen; i < num_history; i++) {
+        if(isnan(history[i]))
+            continue;
+        if(!have_ref) {
+            ref = history[i];
+            have_ref = 1;
+        }
+        x = history[i] - ref;
+        sum += x;
+        sumsq += x * x;
+        n++;
+    }
+
+    for(i = 0; i < count; i++) {
+        if(!isnan(values[i])) {
+            if(!have_ref) {
+                ref = values[i];
+                have_ref = 1;
+            }
+            if(seen == window && n > 1) {
+                mean = sum / (double)n;
+                var = sumsq / (double)n - mean * mean;
+                if(var > 0.0) {
+                    z = (float)(fabs((double)values[i] - ref - mean) / sqrt(var));
+                    if(z > scan->alerts->sigma)
+                        add_hit(scan, RULE_SIGMA, scan->index + i, z);
+                }
+            }
+            x = values[i] - ref;
+            sum += x;
+            sumsq += x * x;
+            n++;
+        }
+
+        /* the value leaving the window */
+        if(seen < window) {
+            seen++;
+            continue;
+        }
+        old = i >= window ? values[i - window] : history[num_history - (window - i)];
+        if(!isnan(old)) {
+            x = old - ref;
+            sum -= x;
+            sumsq -= x * x;
+            n--;
+        }
+    }
+}
+
+/* reduce_minmax that also checks every value against the alert rules on
+ * the way; history holds up to num_history values from right before
+ * values, for the slope and the sigma window */
+static void scan_alerts(struct alertscan_s *scan, const float *values, size_t count, const float *history, size_t num_history, float *min_value, float *max_value)
+{
+    size_t i = 0, j;
+    int rules = scan->alerts->rules;
+    float lo = FLT_MAX, hi = -FLT_MAX;
+#if UNDGRAPH_SSE2
+    int mask, above = rules & (1 << RULE_ABOVE) ? 0xF : 0, below = rules & (1 << RULE_BELOW) ? 0xF : 0, slope = rules & (1 << RULE_SLOPE) ? 0xF : 0;
+    float tmp[4];
+    __m128 v, d;
+    __m128 vlo = _mm_set1_ps(FLT_MAX);
+    __m128 vhi = _mm_set1_ps(-FLT_MAX);
+    __m128 vabove = _mm_set1_ps(scan->alerts->above);
+    __m128 vbelow = _mm_set1_ps(scan->alerts->below);
+    __m128 vslope = _mm_set1_ps(scan->alerts->slope);
+    __m128 sign = _mm_set1_ps(-0.0f);
+#endif
+
+    /* the first value's step is from the end of the history */
+    if(count) {
+        if(values[0] < lo)
+            lo = values[0];
+        if(values[0] > hi)
+            hi = values[0];
+        check_value(scan, values[0], num_history ? history[num_history - 1] : values[0], scan->index);
+        i = 1;
+    }
+
+#if UNDGRAPH_SSE2
+    for(; i + 4 <= count; i += 4) {
+        v = _mm_loadu_ps(values + i);
+        d = _mm_andnot_ps(sign, _mm_sub_ps(v, _mm_loadu_ps(values + i - 1)));
+        vlo = _mm_min_ps(v, vlo);
+        vhi = _mm_max_ps(v, vhi);
+        mask = (_mm_movemask_ps(_mm_cmpgt_ps(v, vabove)) & above) | (_mm_movemask_ps(_mm_cmplt_ps(v, vbelow)) & below) |
+            (_mm_movemask_ps(_mm_cmpgt_ps(d, vslope)) & slope);
+        if(mask) {
+            for(j = i; j < i + 4; j++)
+                check_value(scan, values[j], values[j - 1], scan->index + j);
+        }
+    }
+    _mm_storeu_ps(tmp, vlo);
+    for(j = 0; j < 4; j++)
+        lo = tmp[j] < lo ? tmp[j] : lo;
+    _mm_storeu_ps(tmp, vhi);
+    for(j = 0; j < 4; j++)
+        hi = tmp[j] > hi ? tmp[j] : hi;
+#endif
+    for(; i < count; i++) {
+        if(values[i] < lo)
+            lo = values[i];
+        if(values[i] > hi)
+            hi = values[i];
+        check_value(scan, values[i], values[i - 1], scan->index + i);
+    }
+
+    if(rules & (1 << RULE_SIGMA))
+        scan_sigma(scan, values, count, history, num_history);
+    *min_value = lo;
+    *max_value = hi;
+}
+
+struct spanjob_s {
+    const float *src;
+    float *dst;
+    size_t count;
+    float min_value;
+    float max_value;
+    mutex_t lock;
+};
+
+static void copy_span(void *arg, size_t first, size_t last)
+{
+    struct spanjob_s *job = arg;
+    size_t lo = first * SAMPLES_PER_BLOCK, hi = last * SAMPLES_PER_BLOCK;
+    if(hi > job->count)
+        hi = job->count;
+    if(lo < hi)
+        memcpy(job->dst + lo, job->src + lo, sizeof(float) * (hi - lo));
+}
+
+static void reduce_span(void *arg, size_t first, size_t last)
+{
+    struct spanjob_s *job = arg;
+    size_t lo = first * SAMPLES_PER_BLOCK, hi = last * SAMPLES_PER_BLOCK;
+    float min_value, max_value;
+
+    if(hi > job->count)
+        hi = job->count;
+    if(lo >= hi)
+        return;
+
+    reduce_minmax(job->src + lo, hi - lo, &min_value, &max_value);
+    mutex_lock(&job->lock);
+    if(min_value < job->min_value)
+        job->min_value = min_value;
+    if(max_value > job->max_value)
+        job->max_value = max_value;
+    mutex_unlock(&job->lock);
+}
+
+/* copies src into fresh memory so that every node first-touches its own slice */
+static void copy_nodes(float *dst, const float *src, size_t count, struct nodejob_s *nodes)
+{
+    struct spanjob_s job;
+    job.src = src;
+    job.dst = dst;
+    job.count = count;
+    pool_for_nodes(nodes, (count + SAMPLES_PER_BLOCK - 1) / SAMPLES_PER_BLOCK, sizeof(float) * SAMPLES_PER_BLOCK, &copy_span, &job);
+}
+
+static void reduce_nodes(const float *values, size_t count, float *min_value, float *max_value, struct nodejob_s *nodes)
+{
+    struct spanjob_s job;
+    job.src = values;
+    job.count = count;
+    job.min_value = FLT_MAX;
+    job.max_value = -FLT_MAX;
+    mutex_init(&job.lock);
+    pool_for_nodes(nodes, (count + SAMPLES_PER_BLOCK - 1) / SAMPLES_PER_BLOCK, sizeof(float) * SAMPLES_PER_BLOCK, &reduce_span, &job);
+    mutex_destroy(&job.lock);
+    *min_value = job.min_value;
+    *max_value = job.max_value;
+}
+
+struct gatherjob_s {
+    struct pipeline_s *pl;
+    struct graphdata_s *data;
+    size_t *starts;
+    size_t num_chunks;
+    size_t halo;
+    float **history;
+    int pass;
+    float *scratch;
+    unsigned char *buffers;
+    mutex_t lock;
+};
+
+/* copies count values from pos on out of the parsed chunks */
+static void copy_chunks(const struct gatherjob_s *job, size_t pos, size_t count, float *dst)
+{
+    size_t c, n, l, r, at, end = pos + count;
+
+    /* last chunk that starts at or before the first value */
+    l = 0;
+    r = job->num_chunks;
+    while(r - l > 1) {
+        c = (l + r) / 2;
+        if(job->starts[c] <= pos)
+            l = c;
+        else
+            r = c;
+    }
+
+    for(c = l; pos < end; c++) {
+        at = pos - job->starts[c];
+        n = job->pl->chunks[c]->count - at;
+        if(n > end - pos)
+            n = end - pos;
+        memcpy(dst, job->pl->chunks[c]->values + at, sizeof(float) * n);
+        dst += n;
+        pos += n;
+    }
+}
+
+/* copies a run of blocks out of the parsed chunks, reducing on the way */
+static void gather_blocks(void *arg, size_t first, size_t last)
+{
+    struct gatherjob_s *job = arg;
+    struct graphdata_s *data = job->data;
+    size_t lo, hi, halo;
+    float min_value, max_value;
+    struct alertscan_s scan;
+
+    lo = first * SAMPLES_PER_BLOCK;
+    hi = last * SAMPLES_PER_BLOCK;
+    if(hi > data->size)
+        hi = data->size;
+    if(lo >= hi)
+        return;
+
+    copy_chunks(job, lo, hi - lo, data->data + lo);
+
+    /* the values before lo may not be gathered yet, so the alert rules
+     * take theirs from the chunks too */
+    if(data->alerts.rules) {
+        halo = lo < job->halo ? lo : job->halo;
+        copy_chunks(job, lo - halo, halo, job->history[worker_index]);
+        init_scan(&scan, &data->alerts, &data->alert_list);
+        scan.index = lo;
+        scan_alerts(&scan, data->data + lo, hi - lo, job->history[worker_index], halo, &min_value, &max_value);
+        flush_hits(&scan);
+    }
+    else
+        reduce_minmax(data->data + lo, hi - lo, &min_value, &max_value);
+    mutex_lock(&job->lock);
+    if(min_value < data->min_value)
+        data->min_value = min_value;
+    if(max_value > data->max_value)
+        data->max_value = max_value;
+    mutex_unlock(&job->lock);
+}
+
+/* with compression on, blocks go from the chunks straight into the
+ * store and no flat copy of the samples is made: the first pass picks
+ * every block's codec and size, the second packs them at their offsets */
+static void encode_blocks(void *arg, size_t first, size_t last)
+{
+    struct gatherjob_s *job = arg;
+    struct graphdata_s *data = job->data;
+    size_t block, lo, halo;
+    float *values = job->scratch + (size_t)worker_index * SAMPLES_PER_BLOCK;
+    unsigned char *buffers = job->buffers + (size_t)worker_index * 2 * max_encoded_size(SAMPLES_PER_BLOCK);
+    float min_value = FLT_MAX, max_value = -FLT_MAX;
+    struct sampleblock_s *sb;
+    struct alertscan_s scan;
+
+    for(block = first; block < last; block++) {
+        sb = &data->store.blocks[block];
+        lo = block * SAMPLES_PER_BLOCK;
+        sb->count = data->size - lo < SAMPLES_PER_BLOCK ? data->size - lo : SAMPLES_PER_BLOCK;
+        copy_chunks(job, lo, sb->count, values);
+
+        if(job->pass) {
+            encode_block(values, sb->count, sb->codec, buffers);
+            memcpy(data->store.bytes + sb->offset, buffers, sb->nbytes);
+            continue;
+        }
+
+        choose_codec(values, sb, buffers);
+        if(data->alerts.rules) {
+            halo = lo < job->halo ? lo : job->halo;
+            copy_chunks(job, lo - halo, halo, job->history[worker_index]);
+            init_scan(&scan, &data->alerts, &data->alert_list);
+            scan.index = lo;
+            scan_alerts(&scan, values, sb->count, job->history[worker_index], halo, &sb->min_value, &sb->max_value);
+            flush_hits(&scan);
+        }
+        if(sb->min_value < min_value)
+            min_value = sb->min_value;
+        if(sb->max_value > max_value)
+            max_value = sb->max_value;
+    }
+
+    if(job->pass)
+        return;
+    mutex_lock(&job->lock);
+    if(min_value < data->min_value)
+        data->min_value = min_value;
+    if(max_value > data->max_value)
+        data->max_value = max_value;
+    mutex_unlock(&job->lock);
+}
+
+/* stitches the parsed chunks back together in order; they only hold
+ * the selected values already */
+static void gather_chunks(struct pipeline_s *pl, const char *filename, struct graphdata_s *data)
+{
+    size_t i, total;
+    int stopped = 0;
+    struct gatherjob_s job;
+    struct nodejob_s nodes;
+    struct samplestore_s *store = &data->store;
+
+    job.pl = pl;
+    job.data = data;
+    job.starts = arena_alloc(data->arena, sizeof(size_t) * (pl->num_chunks + 1));
+
+    total = 0;
+    for(i = 0; i < pl->num_chunks && pl->chunks[i] && !stopped; i++) {
+        job.starts[i] = total;
+        total += pl->chunks[i]->count;
+        stopped = pl->chunks[i]->stop;
+    }
+    job.num_chunks = i;
+
+    lprintf("%s: found %zu values\n", filename, total);
+
+    data->size = total;
+    if(!(data->compress || options.force_compress) || !total)
+        data->data = arena_alloc(data->arena, sizeof(float) * data->size);
+
+    data->max_value = -FLT_MAX;
+    data->min_value = FLT_MAX;
+
+    if(data->alerts.rules) {
+        job.halo = alert_halo(&data->alerts);
+        job.history = arena_alloc(data->arena, sizeof(float *) * (size_t)pool_width());
+        for(i = 0; i < (size_t)pool_width(); i++)
+            job.history[i] = arena_alloc(data->arena, sizeof(float) * job.halo);
+        start_alerts(data);
+    }
+
+    /* the pages land on the node of whichever thread touches them first */
+    mutex_init(&job.lock);
+    if(data->data)
+        pool_for_nodes(&nodes, count_blocks(data), sizeof(float) * SAMPLES_PER_BLOCK, &gather_blocks, &job);
+    else {
+        store->num_blocks = count_blocks(data);
+        store->blocks = arena_alloc(data->arena, sizeof(struct sampleblock_s) * store->num_blocks);
+        job.scratch = arena_alloc(data->arena, sizeof(float) * SAMPLES_PER_BLOCK * (size_t)pool_width());
+        job.buffers = arena_alloc(data->arena, 2 * max_encoded_size(SAMPLES_PER_BLOCK) * (size_t)pool_width());
+        job.pass = 0;
+        pool_for_nodes(&nodes, store->num_blocks, sizeof(float) * SAMPLES_PER_BLOCK, &encode_blocks, &job);
+        for(i = 0, store->nbytes = 0; i < store->num_blocks; i++) {
+            store->blocks[i].offset = store->nbytes;
+            store->nbytes += store->blocks[i].nbytes;
+        }
+        store->bytes = arena_alloc(data->arena, store->nbytes);
+        job.pass = 1;
+        pool_for_nodes(&nodes, store->num_blocks, sizeof(float) * SAMPLES_PER_BLOCK, &encode_blocks, &job);
+        print_store(data, sizeof(float) * data->size - store->nbytes);
+    }
+    mutex_destroy(&job.lock);
+    print_node_stats(filename, &nodes);
+    if(data->alerts.rules)
+        data->alerts_scanned = 1;
+}
+
+static void line_index_name(const char *filename, char *path, size_t size)
+{
+    snprintf(path, size, "%s.idx", filename);
+}
+
+/*
+ * Line index layout (little endian):
+ *  magic, size and mtime of the indexed file, entry count
+ *  entries: line number and byte offset of a line start, ascending
+ */
+static int read_line_index(const char *filename, size_t line, size_t *mark_line, uint64_t *mark_offset)
+{
+    int ok;
+    size_t lo, hi, mid, count;
+    char path[4096], magic[8];
+    struct stat st;
+    FILE *fp;
+
+    if(stat(filename, &st))
+        return 0;
+
+    line_index_name(filename, path, sizeof(path));
+    fp = fopen(path, "rb");
+    if(!fp)
+        return 0;
+
+    if(fread(magic, 1, 8, fp) != 8 || memcmp(magic, LINEINDEX_MAGIC, 8) ||
+        read_u64(fp) != (uint64_t)st.st_size || read_u64(fp) != (uint64_t)st.st_mtime) {
+        lprintf("%s: stale or invalid, ignored\n", path);
+        fclose(fp);
+        return 0;
+    }
+
+    /* last entry at or before the line */
+    count = (size_t)read_u64(fp);
+    for(lo = 0, hi = count; hi - lo > 1;) {
+        mid = (lo + hi) / 2;
+        seek_file(fp, LINEINDEX_HEADER_SIZE + (uint64_t)mid * LINEINDEX_ENTRY_SIZE);
+        if(read_u64(fp) <= line)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    if(!count || seek_file(fp, LINEINDEX_HEADER_SIZE + (uint64_t)lo * LINEINDEX_ENTRY_SIZE)) {
+        fclose(fp);
+        return 0;
+    }
+
+    *mark_line = (size_t)read_u64(fp);
+    *mark_offset = read_u64(fp);
+    ok = !ferror(fp) && *mark_line <= line;
+    fclose(fp);
+    return ok;
+}
+
+static void write_line_index(const char *filename, const struct pipeline_s *pl)
+{
+    size_t i;
+    char path[4096];
+    struct stat st;
+    FILE *fp;
+
+    if(stat(filename, &st))
+        return;
+
+    line_index_name(filename, path, sizeof(path));
+    fp = fopen(path, "wb");
+    if(!fp) {
+        lprintf("%s: %s\n", path, strerror(errno));
+        return;
+    }
+
+    fwrite(LINEINDEX_MAGIC, 1, 8, fp);
+    write_u64(fp, (uint64_t)st.st_size);
+    write_u64(fp, (uint64_t)st.st_mtime);
+    write_u64(fp, pl->num_marks);
+    for(i = 0; i < 2 * pl->num_marks; i++)
+        write_u64(fp, pl->marks[i]);
+
+    if(ferror(fp))
+        lprintf("%s: write error\n", path);
+    else
+        lprintf("%s: %zu entries up to line %zu\n", path, pl->num_marks, pl->line);
+    fclose(fp);
+}
+
+/* the calling thread decompresses, the pool parses what it hands over;
+ * first_line and offset say where in the file the carry starts */
+static int parse_pipelined(struct instream_s *in, const char *carry, size_t carry_len, size_t first_line, uint64_t offset, const char *filename, struct graphdata_s *data)
+{
+    size_t seq = 0;
+    atom_t limit;
+    char *tail;
+    struct chunk_s *chunk;
+    struct taskgroup_s group = { 0 };
+    struct pipeline_s pl;
+    struct arena_s chunk_arena;
+
+    /* the chunks are gone once gathered, so they get an arena of their
+     * own that goes back to the system afterwards */
+    arena_init(&chunk_arena);
+    memset(&pl, 0, sizeof(pl));
+    pl.arena = &chunk_arena;
+    pl.in = in;
+    pl.begin = data->range_begin;
+    pl.end = data->range_end ? data->range_end : (size_t)-1;
+    pl.stride = data->stride > 1 ? data->stride : 1;
+    pl.select = pl.begin || data->range_end || pl.stride > 1;
+    pl.line = first_line;
+    pl.offset = offset;
+    pl.build_index = data->build_index && in->kind == INPUT_PLAIN;
+    mutex_init(&pl.lock);
+
+    tail = arena_alloc(pl.arena, CHUNK_SIZE);
+    memcpy(tail, carry, carry_len);
+
+    /* bounds the number of chunk buffers alive at once */
+    limit = QUEUE_DEPTH + pool_width();
+
+    while(!atom_load(&pl.stopped)) {
+        while(atom_load(&pl.outstanding) >= limit)
+            pool_help();
+
+        chunk = read_chunk(&pl, tail, &carry_len, seq);
+        if(!chunk->len)
+            break;
+
+        /* whole chunks outside the range are never parsed */
+        if(pl.select && chunk->first_line >= pl.end) {
+            recycle_chunk(&pl, chunk);
+            break;
+        }
+        if(pl.select && chunk->first_line + chunk->lines <= pl.begin) {
+            recycle_chunk(&pl, chunk);
+            continue;
+        }
+
+        seq++;
+        chunk->task.func = &parse_task;
+        chunk->task.arg = chunk;
+        atom_add(&pl.outstanding, 1);
+        pool_submit(&group, &chunk->task);
+    }
+
+    pool_wait(&group);
+
+    /* reported separately to tell which of the two limits the load: the
+     * reader's rate over its whole run, and how long the parser sat
+     * waiting for it, near zero when parsing is the slower side */
+    lprintf("%s: io: %.1f MiB, %.1f MiB/s, parser waited %.1f ms\n", filename, (double)in->io.io_bytes / 1048576.0,
+        (double)in->io.io_bytes / 1048576.0 / (in->io.io_end - in->io.io_start > 0.0 ? in->io.io_end - in->io.io_start : 1e-9),
+        in->io.io_wait * 1000.0);
+    lprintf("%s: parse: %.1f MiB, %.1f MiB/s on %d thread(s)\n", filename, (double)pl.bytes_in / 1048576.0,
+        (double)pl.bytes_in / 1048576.0 / (pl.parse_time > 0.0 ? pl.parse_time : 1e-9) * pool_width(), pool_width());
+
+    gather_chunks(&pl, filename, data);
+    if(pl.build_index)
+        write_line_index(filename, &pl);
+
+    mutex_destroy(&pl.lock);
+    arena_destroy(&chunk_arena);
+    return 1;
+}
+
+/* N or N:window, for sigma:N[:W] and --sigma */
+static int parse_sigma(const char *text, struct alerts_s *alerts)
+{
+    int n;
+
+    alerts->window = SIGMA_WINDOW;
+    n = sscanf(text, "%f:%zu", &alerts->sigma, &alerts->window);
+    return n >= 1 && alerts->sigma > 0.0f && alerts->window > 1;
+}
+
+static int parse_header(const char *line, const char *filename, struct graphdata_s *data)
+{
+    int nc, nr;
+    size_t len;
+    char tag[32];
+    const char *lp = line;
+
+    nc = 0;
+    len = strlen(line);
+
+    /* header: magic */
+    sscanf(lp += nc, "%31s %n", tag, &nc);
+    if(strcmp(tag, "undgraph")) {
+        lprintf("%s: invalid header format\n", filename);
+        return 0;
+    }
+
+    /* header: tags */
+    while((size_t)(lp - line) < len && (nr = sscanf(lp += nc, " %31s %n", tag, &nc)) > 0) {
+        if(strstr(tag, "msaa") == tag) {
+            sscanf(tag, "msaa:%d", &data->msaa);
+            continue;
+        }
+
+        if(strstr(tag, "save") == tag) {
+            sscanf(tag, "save:%d", &data->save);
+            continue;
+        }
+
+        if(strstr(tag, "compress") == tag) {
+            sscanf(tag, "compress:%d", &data->compress);
+            continue;
+        }
+
+        /* the command line wins over the file */
+        if(strstr(tag, "range") == tag) {
+            if(!data->range_begin && !data->range_end)
+                sscanf(tag, "range:%zu:%zu", &data->range_begin, &data->range_end);
+            continue;
+        }
+
+        if(strstr(tag, "stride") == tag) {
+            if(data->stride <= 1)
+                sscanf(tag, "stride:%zu", &data->stride);
+            continue;
+        }
+
+        if(strstr(tag, "lttb") == tag) {
+            sscanf(tag, "lttb:%zu", &data->lttb);
+            continue;
+        }
+
+        if(strstr(tag, "ma:") == tag) {
+            sscanf(tag, "ma:%zu", &data->ma_window);
+            continue;
+        }
+
+        if(strstr(tag, "ewma") == tag) {
+            sscanf(tag, "ewma:%f", &data->ewma_alpha);
+            if(!(data->ewma_alpha > 0.0f && data->ewma_alpha <= 1.0f)) {
+                lprintf("%s: warning: ewma wants 0 < alpha <= 1\n", filename);
+                data->ewma_alpha = 0.0f;
+            }
+            continue;
+        }
+
+        if(strstr(tag, "minmax") == tag) {
+            sscanf(tag, "minmax:%zu", &data->minmax_window);
+            continue;
+        }
+
+        if(strstr(tag, "pct") == tag) {
+            sscanf(tag, "pct:%zu", &data->pct_window);
+            continue;
+        }
+
+        if(strstr(tag, "history") == tag) {
+            sscanf(tag, "history:%zu", &data->history);
+            continue;
+        }
+
+        if(strstr(tag, "hist:") == tag) {
+            sscanf(tag, "hist:%zu", &data->hist_bins);
+            continue;
+        }
+
+        if(strstr(tag, "fft") == tag) {
+            sscanf(tag, "fft:%zu", &data->fft_size);
+            continue;
+        }
+
+        if(strstr(tag, "envelope") == tag) {
+            sscanf(tag, "envelope:%d", &data->envelope);
+            continue;
+        }
+
+        if(strstr(tag, "mean") == tag) {
+            sscanf(tag, "mean:%d", &data->envelope_mean);
+            continue;
+        }
+
+        /* rules given on the command line win over the header */
+        if(strstr(tag, "above") == tag) {
+            if(!(data->alerts.rules & (1 << RULE_ABOVE)) && sscanf(tag, "above:%f", &data->alerts.above) == 1)
+                data->alerts.rules |= 1 << RULE_ABOVE;
+            continue;
+        }
+
+        if(strstr(tag, "below") == tag) {
+            if(!(data->alerts.rules & (1 << RULE_BELOW)) && sscanf(tag, "below:%f", &data->alerts.below) == 1)
+                data->alerts.rules |= 1 << RULE_BELOW;
+            continue;
+        }
+
+        if(strstr(tag, "slope") == tag) {
+            if(!(data->alerts.rules & (1 << RULE_SLOPE)) && sscanf(tag, "slope:%f", &data->alerts.slope) == 1)
+                data->alerts.rules |= 1 << RULE_SLOPE;
+            continue;
+        }
+
+        if(strstr(tag, "sigma") == tag) {
+            if(!(data->alerts.rules & (1 << RULE_SIGMA)) && parse_sigma(tag + 6, &data->alerts))
+                data->alerts.rules |= 1 << RULE_SIGMA;
+            continue;
+        }
+
+        if(strstr(tag, "axes") == tag) {
+            sscanf(tag, "axes:%d", &data->axes);
+            continue;
+        }
+
+        if(strstr(tag, "cdf") == tag) {
+            sscanf(tag, "cdf:%d", &data->cdf);
+            continue;
+        }
+
+        if(strstr(tag, "lw") == tag) {
+            sscanf(tag, "lw:%f", &data->line_width);
+            continue;
+        }
+
+        if(strstr(tag, "frame_px") == tag) {
+            sscanf(tag, "frame_px:%f", &data->frame_px);
+            continue;
+        }
+
+        lprintf("%s: warning: unknown tag: %s\n", filename, tag);
+    }
+
+    return 1;
+}
+
+/* a 1, 2 or 5 times a power of ten that splits range into about count steps */
+static double nice_step(double range, int count)
+{
+    double raw, mag, norm;
+
+    if(!(range > 0.0))
+        return 1.0;
+    raw = range / (double)count;
+    mag = pow(10.0, floor(log10(raw)));
+    norm = raw / mag;
+    if(norm < 1.5)
+        return mag;
+    if(norm < 3.0)
+        return mag * 2.0;
+    if(norm < 7.0)
+        return mag * 5.0;
+    return mag * 10.0;
+}
+
+static int read_undgraph(const char *filename, struct graphdata_s *data)
+{
+    int kind;
+    size_t n, len, first_line;
+    uint64_t offset;
+    char head[HEADER_SIZE], line[HEADER_SIZE];
+    unsigned char magic[8] = { 0 };
+    struct instream_s in;
+    const char *eol;
+    FILE *fp;
+    
+    fp = fopen(filename, "rb");
+    if(!fp) {
+        lprintf("%s\n", strerror(errno));
+        return 0;
+    }
+
+    /* default tag values */
+    data->msaa = 0;
+    data->save = 0;
+    data->compress = 0;
+    data->line_width = 1.0f;
+    data->frame_px = 0;
+    data->lttb = 0;
+    data->ma_window = 0;
+    data->ewma_alpha = 0.0f;
+    data->minmax_window = 0;
+    data->pct_window = 0;
+    data->hist_bins = 0;
+    data->cdf = 0;
+    data->fft_size = 0;
+    data->envelope = 0;
+    data->envelope_mean = 0;
+    data->axes = 0;
+    data->history = 0;
+
+    /* binary block files share the entry point */
+    n = fread(magic, 1, sizeof(magic), fp);
+    if(n == sizeof(magic) && !memcmp(magic, BLOCKFILE_MAGIC, 8)) {
+        if(!read_undgraph_blocks(filename, fp, data))
+            goto error;
+        goto done;
+    }
+
+    /* so do compressed text files */
+    kind = INPUT_PLAIN;
+    if(n >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+        kind = INPUT_GZIP;
+    else if(n >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+        kind = INPUT_ZSTD;
+
+    fseek(fp, 0, SEEK_SET);
+    if(!open_instream(&in, data->arena, fp, kind, filename, data->direct_io))
+        goto error;
+
+    /* header */
+    n = read_instream(&in, head, sizeof(head) - 1);
+    head[n] = 0;
+    eol = memchr(head, '\n', n);
+    len = eol ? (size_t)(eol - head) + 1 : n;
+    memcpy(line, head, len);
+    line[len] = 0;
+
+    if(!parse_header(line, filename, data)) {
+        close_instream(&in);
+        goto error;
+    }
+
+    /* whatever followed the header goes into the first chunk, unless the
+     * line index knows a later place to start at */
+    first_line = 0;
+    offset = len;
+    if(kind == INPUT_PLAIN && data->range_begin && !data->build_index &&
+        read_line_index(filename, data->range_begin, &first_line, &offset) && first_line) {
+        lprintf("%s: index: starting at line %zu, byte %.0f\n", filename, first_line, (double)offset);
+        seek_instream(&in, offset);
+        n = len;
+    }
+
+    if(!parse_pipelined(&in, head + len, n - len, first_line, offset, filename, data)) {
+        close_instream(&in);
+        goto error;
+    }
+
+    close_instream(&in);
+
+done:
+    data->tick_size = (float)nice_step(data->max_value, AXIS_TICKS);
+
+    fclose(fp);
+    return 1;
+
+error:
+    fclose(fp);
+    return 0;
+}
+
+static GLuint compile_shader(GLenum stage, const char *source)
+{
+    char *info_log;
+    GLuint shader;
+    GLint gli;
+    
+    shader = glCreateShader(stage);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    /* check info log */
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &gli);
+    if(gli > 1) {
+        info_log = malloc(gli + 1);
+        assert(("Out of memory!", info_log));
+        info_log[gli] = 0;
+        glGetShaderInfoLog(shader, gli, NULL, info_log);
+        lprintf("%s\n", info_log);
+        free(info_log);
+    }
+
+    /* check status */
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &gli);
+    if(gli != GL_TRUE) {
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+static GLuint link_program(GLuint vs, GLuint fs)
+{
+    char *info_log;
+    GLuint program;
+    GLint gli;
+
+    program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+
+    /* check info log */
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &gli);
+    if(gli > 1) {
+        info_log = malloc(gli + 1);
+        assert(("Out of memory!", info_log));
+        info_log[gli] = 0;
+        glGetProgramInfoLog(program, gli, NULL, info_log);
+        lprintf("%s\n", info_log);
+        free(info_log);
+    }
+
+    /* check status */
+    glGetProgramiv(program, GL_LINK_STATUS, &gli);
+    if(gli != GL_TRUE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+struct meshjob_s {
+    const struct graphdata_s *data;
+    const float *series;
+    vec2_t *mesh;
+    float *scratch;
+};
+
+static void mesh_blocks(void *arg, size_t first, size_t last)
+{
+    struct meshjob_s *job = arg;
+    const struct graphdata_s *data = job->data;
+    vec2_t *mesh = job->mesh;
+    size_t i, j, block, count;
+    float *scratch = job->scratch + (size_t)worker_index * SAMPLES_PER_BLOCK;
+    const float *values;
+
+    for(block = first; block < last; block++) {
+        if(job->series) {
+            values = job->series + block * SAMPLES_PER_BLOCK;
+            count = data->size - block * SAMPLES_PER_BLOCK;
+            if(count > SAMPLES_PER_BLOCK)
+                count = SAMPLES_PER_BLOCK;
+        }
+        else
+            values = get_block(data, block, scratch, &count);
+        for(j = 0, i = block * SAMPLES_PER_BLOCK; j < count; j++, i++) {
+            mesh[i][0] = (float)data->frame_px + (float)i * (float)(WIDTH - data->frame_px * 2) / (float)data->size;
+            mesh[i][1] = (float)data->frame_px + values[j] / data->max_value * (float)(HEIGHT - data->frame_px * 2);
+            if(isinf(mesh[i][0]))
+                lprintf("warning: vertex[%zu].x = infinity\n", i);
+            else if(isnan(mesh[i][0]))
+                lprintf("warning: vertex[%zu].x = nan\n", i);
+            if(isinf(mesh[i][1]))
+                lprintf("warning: vertex[%zu].y = infinity\n", i);
+            else if(isnan(mesh[i][1]))
+                lprintf("warning: vertex[%zu].y = nan\n", i);
+        }
+    }
+}
+
+/* blocks are independent; each node meshes the slice it loaded. series
+ * stands in for the samples when it is set */
+static void build_mesh(const struct graphdata_s *data, const float *series, vec2_t *mesh)
+{
+    struct meshjob_s job;
+    struct nodejob_s nodes;
+
+    job.data = data;
+    job.series = series;
+    job.mesh = mesh;
+    job.scratch = arena_alloc(data->arena, sizeof(float) * SAMPLES_PER_BLOCK * (size_t)pool_width());
+    pool_for_nodes(&nodes, count_blocks(data), sizeof(float) * SAMPLES_PER_BLOCK, &mesh_blocks, &job);
+    arena_free(data->arena, job.scratch);
+}
+
+/* flat view of the samples, decoding the store if it is compressed */
+static const float *flat_samples(const struct graphdata_s *data)
+{
+    size_t i, count;
+    float *flat;
+    const float *block;
+
+    if(data->data)
+        return data->data;
+
+    flat = arena_alloc(data->arena, sizeof(float) * data->size);
+    for(i = 0; i < count_blocks(data); i++) {
+        block = get_block(data, i, flat + i * SAMPLES_PER_BLOCK, &count);
+        if(block != flat + i * SAMPLES_PER_BLOCK)
+            memcpy(flat + i * SAMPLES_PER_BLOCK, block, sizeof(float) * count);
+    }
+    return flat;
+}
+
+/* gives back what flat_samples decoded once the caller is done with it */
+static void release_flat(const struct graphdata_s *data, const float *values)
+{
+    if(values && values != data->data)
+        arena_shrink(data->arena, (void *)values, sizeof(float) * data->size, 0);
+}
+
+struct lttbjob_s {
+    const float *values;
+    size_t size;
+    size_t num_buckets;
+    size_t num_segments;
+    double every;
+    double *avg;
+    size_t *picked;
+};
+
+/* bucket b covers [start, end) of the samples between the two fixed ends */
+static void lttb_bucket(const struct lttbjob_s *job, size_t b, size_t *start, size_t *end)
+{
+    *start = (size_t)((double)b * job->every) + 1;
+    *end = (size_t)((double)(b + 1) * job->every) + 1;
+    if(*end > job->size - 1)
+        *end = job->size - 1;
+}
+
+static void lttb_average(void *arg, size_t segment)
+{
+    struct lttbjob_s *job = arg;
+    size_t b, i, start, end;
+    double sum;
+
+    for(b = segment * job->num_buckets / job->num_segments; b < (segment + 1) * job->num_buckets / job->num_segments; b++) {
+        lttb_bucket(job, b, &start, &end);
+        for(sum = 0.0, i = start; i < end; i++)
+            sum += job->values[i];
+        job->avg[b] = end > start ? sum / (double)(end - start) : job->values[start];
+    }
+}
+
+/* the point of bucket b that spans the largest triangle with the one
+ * picked before it and the average of the bucket after it */
+static size_t lttb_pick(const struct lttbjob_s *job, size_t b, double ax, double ay)
+{
+    size_t i, start, end, best;
+    double cx, cy, area, best_area = -1.0;
+
+    if(b + 1 < job->num_buckets) {
+        lttb_bucket(job, b + 1, &start, &end);
+        cx = (double)(start + end - 1) * 0.5;
+        cy = job->avg[b + 1];
+    }
+    else {
+        cx = (double)(job->size - 1);
+        cy = job->values[job->size - 1];
+    }
+
+    lttb_bucket(job, b, &start, &end);
+    for(best = start, i = start; i < end; i++) {
+        area = fabs((ax - cx) * ((double)job->values[i] - ay) - (ax - (double)i) * (cy - ay));
+        if(area > best_area) {
+            best_area = area;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/* a segment starts from the average of the bucket before it instead of the
+ * point picked there, which is what lets the segments run independently */
+static void lttb_select(void *arg, size_t segment)
+{
+    struct lttbjob_s *job = arg;
+    size_t b, start, end;
+    size_t first = segment * job->num_buckets / job->num_segments;
+    size_t last = (segment + 1) * job->num_buckets / job->num_segments;
+    double ax, ay;
+
+    if(first) {
+        lttb_bucket(job, first - 1, &start, &end);
+        ax = (double)(start + end - 1) * 0.5;
+        ay = job->avg[first - 1];
+    }
+    else {
+        ax = 0.0;
+        ay = job->values[0];
+    }
+
+    for(b = first; b < last; b++) {
+        job->picked[b + 1] = lttb_pick(job, b, ax, ay);
+        ax = (double)job->picked[b + 1];
+        ay = job->values[job->picked[b + 1]];
+    }
+}
+
+/* redoes the start of every segment with the real anchor; once a pick
+ * agrees, everything after it in the segment does too */
+static void lttb_repair(struct lttbjob_s *job)
+{
+    size_t s, b, best, prev;
+
+    for(s = 1; s < job->num_segments; s++) {
+        for(b = s * job->num_buckets / job->num_segments; b < job->num_buckets; b++) {
+            prev = job->picked[b];
+            best = lttb_pick(job, b, (double)prev, job->values[prev]);
+            if(best == job->picked[b + 1])
+                break;
+            job->picked[b + 1] = best;
+        }
+    }
+}
+
+/* largest-triangle-three-buckets; returns the number of sample indices
+ * written to picked, which has room for target of them */
+static size_t downsample_lttb(const struct graphdata_s *data, size_t target, size_t *picked)
+{
+    struct lttbjob_s job;
+    double start = now_seconds();
+
+    if(target >= data->size || target < 3) {
+        for(job.size = 0; job.size < data->size && job.size < target; job.size++)
+            picked[job.size] = job.size;
+        return job.size;
+    }
+
+    job.values = flat_samples(data);
+    job.size = data->size;
+    job.num_buckets = target - 2;
+    job.every = (double)(data->size - 2) / (double)job.num_buckets;
+    job.num_segments = pool_width() > 1 ? (size_t)pool_width() * 4 : 1;
+    if(job.num_segments > MAX_TASKS)
+        job.num_segments = MAX_TASKS;
+    if(job.num_segments > job.num_buckets)
+        job.num_segments = job.num_buckets;
+    job.picked = picked;
+    job.avg = arena_alloc(data->arena, sizeof(double) * job.num_buckets);
+
+    pool_parallel_for(job.num_segments, &lttb_average, &job);
+    picked[0] = 0;
+    pool_parallel_for(job.num_segments, &lttb_select, &job);
+    lttb_repair(&job);
+    picked[target - 1] = data->size - 1;
+    release_flat(data, job.values);
+
+    lprintf("lttb: %zu -> %zu points in %.1f ms on %zu segment(s)\n", data->size, target,
+        (now_seconds() - start) * 1000.0, job.num_segments);
+    return target;
+}
+
+/* writes a text undgraph file holding just the downsampled points */
+static int write_downsampled(const char *filename, const struct graphdata_s *data, size_t target)
+{
+    size_t i, count;
+    size_t *picked;
+    const float *values;
+    FILE *fp;
+
+    picked = arena_alloc(data->arena, sizeof(size_t) * target);
+    count = downsample_lttb(data, target, picked);
+    values = flat_samples(data);
+
+    fp = fopen(filename, "wb");
+    if(!fp) {
+        lprintf("%s: %s\n", filename, strerror(errno));
+        return 0;
+    }
+
+    fprintf(fp, "undgraph msaa:%d lw:%g frame_px:%g\n", data->msaa, data->line_width, data->frame_px);
+    for(i = 0; i < count; i++)
+        fprintf(fp, "%.9g\n", values[picked[i]]);
+
+    if(ferror(fp)) {
+        lprintf("%s: write error\n", filename);
+        fclose(fp);
+        return 0;
+    }
+
+    fclose(fp);
+    lprintf("%s: wrote %zu of %zu values\n", filename, count, data->size);
+    return 1;
+}
+
+/* the ring and the queues round up to a power of two so they wrap
+ * with a mask */
+static size_t rollminmax_capacity(size_t window)
+{
+    size_t capacity = 1;
+    while(capacity < window)
+        capacity <<= 1;
+    return capacity;
+}
+
+static size_t rollminmax_bytes(size_t window)
+{
+    return (sizeof(float) + sizeof(size_t) * 2) * rollminmax_capacity(window);
+}
+
+static void rollminmax_init(struct rollminmax_s *r, size_t window, void *memory)
+{
+    size_t capacity = rollminmax_capacity(window);
+    r->window = window;
+    r->mask = capacity - 1;
+    r->count = 0;
+    r->min_queue = memory;
+    r->max_queue = r->min_queue + capacity;
+    r->ring = (float *)(r->max_queue + capacity);
+    r->min_head = r->min_len = 0;
+    r->max_head = r->max_len = 0;
+}
+
+/* monotonic queues of sample numbers: the front is the extreme of the
+ * window and every push pops at most what it pushed once */
+static void rollminmax_push(struct rollminmax_s *r, float x, float *lo, float *hi)
+{
+    size_t n = r->count++, m = r->mask;
+
+    if(r->min_len && r->min_queue[r->min_head] + r->window <= n) {
+        r->min_head = (r->min_head + 1) & m;
+        r->min_len--;
+    }
+    if(r->max_len && r->max_queue[r->max_head] + r->window <= n) {
+        r->max_head = (r->max_head + 1) & m;
+        r->max_len--;
+    }
+
+    r->ring[n & m] = x;
+    while(r->min_len && r->ring[r->min_queue[(r->min_head + r->min_len - 1) & m] & m] >= x)
+        r->min_len--;
+    while(r->max_len && r->ring[r->max_queue[(r->max_head + r->max_len - 1) & m] & m] <= x)
+        r->max_len--;
+    r->min_queue[(r->min_head + r->min_len++) & m] = n;
+    r->max_queue[(r->max_head + r->max_len++) & m] = n;
+
+    *lo = r->ring[r->min_queue[r->min_head] & m];
+    *hi = r->ring[r->max_queue[r->max_head] & m];
+}
+
+/* nodes order by value, then by slot, so equal samples stay distinct */
+static int treap_less(const struct treapnode_s *nodes, int a, int b)
+{
+    return nodes[a].key < nodes[b].key || (nodes[a].key == nodes[b].key && a < b);
+}
+
+static int treap_size(const struct treapnode_s *nodes, int t)
+{
+    return t < 0 ? 0 : nodes[t].size;
+}
+
+static void treap_update(struct treapnode_s *nodes, int t)
+{
+    nodes[t].size = 1 + treap_size(nodes, nodes[t].left) + treap_size(nodes, nodes[t].right);
+}
+
+/* splits t into the nodes ordered before node and the rest */
+static void treap_split(struct treapnode_s *nodes, int t, int node, int *l, int *r)
+{
+    if(t < 0) {
+        *l = *r = -1;
+        return;
+    }
+    if(treap_less(nodes, t, node)) {
+        treap_split(nodes, nodes[t].right, node, &nodes[t].right, r);
+        *l = t;
+    }
+    else {
+        treap_split(nodes, nodes[t].left, node, l, &nodes[t].left);
+        *r = t;
+    }
+    treap_update(nodes, t);
+}
+
+/* walks down until node outranks the subtree and splits it there */
+static int treap_insert(struct treapnode_s *nodes, int t, int node)
+{
+    if(t < 0)
+        return node;
+    if(nodes[node].priority > nodes[t].priority) {
+        treap_split(nodes, t, node, &nodes[node].left, &nodes[node].right);
+        treap_update(nodes, node);
+        return node;
+    }
+    if(treap_less(nodes, node, t))
+        nodes[t].left = treap_insert(nodes, nodes[t].left, node);
+    else
+        nodes[t].right = treap_insert(nodes, nodes[t].right, node);
+    nodes[t].size++;
+    return t;
+}
+
+static int treap_merge(struct treapnode_s *nodes, int l, int r)
+{
+    if(l < 0)
+        return r;
+    if(r < 0)
+        return l;
+    if(nodes[l].priority > nodes[r].priority) {
+        nodes[l].right = treap_merge(nodes, nodes[l].right, r);
+        treap_update(nodes, l);
+        return l;
+    }
+    nodes[r].left = treap_merge(nodes, l, nodes[r].left);
+    treap_update(nodes, r);
+    return r;
+}
+
+static int treap_erase(struct treapnode_s *nodes, int t, int node)
+{
+    if(t == node)
+        return treap_merge(nodes, nodes[t].left, nodes[t].right);
+    if(treap_less(nodes, node, t))
+        nodes[t].left = treap_erase(nodes, nodes[t].left, node);
+    else
+        nodes[t].right = treap_erase(nodes, nodes[t].right, node);
+    nodes[t].size--;
+    return t;
+}
+
+static size_t rollpct_bytes(size_t window)
+{
+    return sizeof(struct treapnode_s) * window;
+}
+
+static void rollpct_init(struct rollpct_s *r, size_t window, void *memory)
+{
+    r->window = window;
+    r->count = 0;
+    r->seed = 2463534242U;
+    r->root = -1;
+    r->nodes = memory;
+}
+
+/* the sample leaving the window owns the slot the new one takes */
+static void rollpct_push(struct rollpct_s *r, float x)
+{
+    int slot = (int)(r->count % r->window);
+    struct treapnode_s *node = r->nodes + slot;
+
+    if(r->count++ >= r->window)
+        r->root = treap_erase(r->nodes, r->root, slot);
+
+    r->seed ^= r->seed << 13;
+    r->seed ^= r->seed >> 17;
+    r->seed ^= r->seed << 5;
+    node->key = isnan(x) ? FLT_MAX : x;
+    node->priority = r->seed;
+    node->left = node->right = -1;
+    node->size = 1;
+
+    r->root = treap_insert(r->nodes, r->root, slot);
+}
+
+/* nearest rank quantile of the window */
+static float rollpct_get(const struct rollpct_s *r, double q)
+{
+    int t = r->root, ls;
+    size_t n = r->count < r->window ? r->count : r->window;
+    int k = (int)(q * (double)(n - 1) + 0.5);
+
+    while(t >= 0) {
+        ls = treap_size(r->nodes, r->nodes[t].left);
+        if(k < ls)
+            t = r->nodes[t].left;
+        else if(k == ls)
+            break;
+        else {
+            k -= ls + 1;
+            t = r->nodes[t].right;
+        }
+    }
+    return t >= 0 ? r->nodes[t].key : 0.0f;
+}
+
+static size_t rollmean_bytes(size_t window)
+{
+    return sizeof(float) * window;
+}
+
+static void rollmean_init(struct rollmean_s *r, size_t window, void *memory)
+{
+    r->window = window;
+    r->count = 0;
+    r->sum = 0.0;
+    r->ring = memory;
+}
+
+/* the running sum is re-added from the ring once per window, which keeps
+ * the rounding from drifting and lets a nan age out */
+static float rollmean_push(struct rollmean_s *r, float x)
+{
+    size_t i, slot = r->count % r->window;
+
+    if(r->count >= r->window)
+        r->sum -= r->ring[slot];
+    r->ring[slot] = x;
+    r->sum += x;
+    r->count++;
+
+    if(slot == r->window - 1)
+        for(r->sum = 0.0, i = 0; i < r->window; i++)
+            r->sum += r->ring[i];
+
+    return (float)(r->sum / (double)(r->count < r->window ? r->count : r->window));
+}
+
+static void ewma_init(struct ewma_s *e, double alpha)
+{
+    e->alpha = alpha;
+    e->value = 0.0;
+    e->count = 0;
+}
+
+static float ewma_push(struct ewma_s *e, float x)
+{
+    if(e->count++)
+        e->value += e->alpha * ((double)x - e->value);
+    else
+        e->value = x;
+    return (float)e->value;
+}
+
+static void tdigest_init(struct tdigest_s *d)
+{
+    d->num_centroids = 0;
+    d->num_buffered = 0;
+    d->total = 0.0;
+    d->min = DBL_MAX;
+    d->max = -DBL_MAX;
+}
+
+static int compare_centroids(const void *a, const void *b)
+{
+    double x = ((const struct centroid_s *)a)->mean, y = ((const struct centroid_s *)b)->mean;
+    return x < y ? -1 : x > y;
+}
+
+/* the k1 scale function: the quantile a centroid starting at q may grow
+ * to, which keeps the ones near the tails small */
+static double tdigest_limit(double q)
+{
+    double k = asin(2.0 * q - 1.0) + 2.0 * PI / TDIGEST_DELTA;
+    return k >= PI / 2.0 ? 1.0 : (sin(k) + 1.0) / 2.0;
+}
+
+/* folds the buffer into the centroids in one sorted sweep */
+static void tdigest_flush(struct tdigest_s *d)
+{
+    size_t i, j, n = 0;
+    double so_far = 0.0, limit;
+    struct centroid_s cur, next;
+
+    if(!d->num_buffered)
+        return;
+
+    qsort(d->buffer, d->num_buffered, sizeof(struct centroid_s), &compare_centroids);
+    for(i = j = 0; i < d->num_centroids || j < d->num_buffered;) {
+        if(j == d->num_buffered || (i < d->num_centroids && d->centroids[i].mean <= d->buffer[j].mean))
+            d->merged[n++] = d->centroids[i++];
+        else
+            d->merged[n++] = d->buffer[j++];
+    }
+
+    cur = d->merged[0];
+    limit = tdigest_limit(0.0) * d->total;
+    d->num_centroids = 0;
+    for(i = 1; i < n; i++) {
+        next = d->merged[i];
+        if(so_far + cur.weight + next.weight <= limit || d->num_centroids + 1 == TDIGEST_CENTROIDS) {
+            cur.weight += next.weight;
+            cur.mean += (next.mean - cur.mean) * next.weight / cur.weight;
+            continue;
+        }
+        so_far += cur.weight;
+        d->centroids[d->num_centroids++] = cur;
+        limit = tdigest_limit(so_far / d->total) * d->total;
+        cur = next;
+    }
+    d->centroids[d->num_centroids++] = cur;
+    d->num_buffered = 0;
+}
+
+static void tdigest_add(struct tdigest_s *d, double x, double weight)
+{
+    if(isnan(x))
+        return;
+    if(x < d->min)
+        d->min = x;
+    if(x > d->max)
+        d->max = x;
+    d->buffer[d->num_buffered].mean = x;
+    d->buffer[d->num_buffered].weight = weight;
+    d->total += weight;
+    if(++d->num_buffered == TDIGEST_BUFFER)
+        tdigest_flush(d);
+}
+
+static void tdigest_merge(struct tdigest_s *d, struct tdigest_s *src)
+{
+    size_t i;
+
+    tdigest_flush(src);
+    for(i = 0; i < src->num_centroids; i++)
+        tdigest_add(d, src->centroids[i].mean, src->centroids[i].weight);
+    if(src->num_centroids) {
+        d->min = src->min < d->min ? src->min : d->min;
+        d->max = src->max > d->max ? src->max : d->max;
+    }
+}
+
+/* interpolates between the centroid centers, with the exact extremes
+ * pinned at both ends */
+static double tdigest_quantile(struct tdigest_s *d, double q)
+{
+    size_t i;
+    double index, pos, cum = 0.0, prev_pos = 0.0, prev = d->min;
+
+    tdigest_flush(d);
+    if(!d->num_centroids)
+        return 0.0;
+
+    index = q * d->total;
+    for(i = 0; i < d->num_centroids; i++) {
+        pos = cum + d->centroids[i].weight / 2.0;
+        if(index < pos)
+            return prev + (index - prev_pos) / (pos - prev_pos) * (d->centroids[i].mean - prev);
+        prev_pos = pos;
+        prev = d->centroids[i].mean;
+        cum += d->centroids[i].weight;
+    }
+    if(d->total <= prev_pos)
+        return d->max;
+    return prev + (index - prev_pos) / (d->total - prev_pos) * (d->max - prev);
+}
+
+/* prefix[0] = 0, prefix[i + 1] = values[0] + ... + values[i] */
+static void prefix_sums(const float *values, size_t count, double *prefix)
+{
+    size_t i = 0;
+    double run = 0.0;
+#if UNDGRAPH_SSE2
+    __m128 v;
+    __m128d lo, hi, carry = _mm_setzero_pd();
+    for(; i + 4 <= count; i += 4) {
+        v = _mm_loadu_ps(values + i);
+        lo = _mm_cvtps_pd(v);
+        hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+        lo = _mm_add_pd(lo, _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(lo), 8)));
+        hi = _mm_add_pd(hi, _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(hi), 8)));
+        hi = _mm_add_pd(hi, _mm_unpackhi_pd(lo, lo));
+        _mm_storeu_pd(prefix + i + 1, _mm_add_pd(lo, carry));
+        hi = _mm_add_pd(hi, carry);
+        _mm_storeu_pd(prefix + i + 3, hi);
+        carry = _mm_unpackhi_pd(hi, hi);
+    }
+    _mm_store_sd(&run, carry);
+#endif
+    prefix[0] = 0.0;
+    for(; i < count; i++) {
+        run += values[i];
+        prefix[i + 1] = run;
+    }
+}
+
+/* out[i] = (hi[i] - lo[i]) * scale */
+static void window_means(const double *hi, const double *lo, size_t count, double scale, float *out)
+{
+    size_t i = 0;
+#if UNDGRAPH_SSE2
+    __m128d vscale = _mm_set1_pd(scale);
+    for(; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_movelh_ps(
+            _mm_cvtpd_ps(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(hi + i), _mm_loadu_pd(lo + i)), vscale)),
+            _mm_cvtpd_ps(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(hi + i + 2), _mm_loadu_pd(lo + i + 2)), vscale))));
+    }
+#endif
+    for(; i < count; i++)
+        out[i] = (float)((hi[i] - lo[i]) * scale);
+}
+
+struct overlayjob_s {
+    const float *values;
+    size_t size;
+    size_t num_segments;
+    size_t window;
+    double alpha;
+    char *scratch;
+    size_t scratch_bytes;
+    double *carry;
+    float *out[2];
+};
+
+/* a segment warms its window up on the samples before it, so the
+ * segments are independent and the result does not depend on the split */
+static void overlay_segment(const struct overlayjob_s *job, size_t segment, size_t *begin, size_t *end, size_t *warm)
+{
+    *begin = segment * job->size / job->num_segments;
+    *end = (segment + 1) * job->size / job->num_segments;
+    *warm = *begin + 1 > job->window ? *begin + 1 - job->window : 0;
+}
+
+static void ma_segment(void *arg, size_t segment)
+{
+    struct overlayjob_s *job = arg;
+    size_t begin, end, warm, block, last, i, w = job->window;
+    size_t span = w > PREFIX_BLOCK ? w : PREFIX_BLOCK;
+    double *prefix = (double *)(job->scratch + (size_t)worker_index * job->scratch_bytes);
+
+    overlay_segment(job, segment, &begin, &end, &warm);
+    for(block = begin; block < end; block += span) {
+        warm = block + 1 > w ? block + 1 - w : 0;
+        last = block + span < end ? block + span : end;
+        prefix_sums(job->values + warm, last - warm, prefix);
+
+        /* the first samples average over what there is */
+        for(i = block; i < last && i + 1 < w; i++)
+            job->out[0][i] = (float)(prefix[i + 1] / (double)(i + 1));
+        if(i < last)
+            window_means(prefix + (i + 1 - warm), prefix + (i + 1 - warm - w), last - i, 1.0 / (double)w, job->out[0] + i);
+    }
+}
+
+/* pass one runs every segment from zero and keeps where it ended up */
+static void ewma_segment(void *arg, size_t segment)
+{
+    struct overlayjob_s *job = arg;
+    size_t begin, end, warm, i;
+    double y = 0.0;
+
+    overlay_segment(job, segment, &begin, &end, &warm);
+    for(i = begin; i < end; i++) {
+        y += job->alpha * ((double)job->values[i] - y);
+        job->out[0][i] = (float)y;
+    }
+    job->carry[segment * 2] = y;
+}
+
+/* pass two adds the decayed value of everything before the segment, up
+ * to where a float next to the samples could no longer tell it apart */
+static void ewma_fixup(void *arg, size_t segment)
+{
+    struct overlayjob_s *job = arg;
+    size_t begin, end, warm, i;
+    double carry = job->carry[segment * 2 + 1], keep = 1.0 - job->alpha, decay = keep;
+
+    overlay_segment(job, segment, &begin, &end, &warm);
+    for(i = begin; i < end && decay > FLT_EPSILON * FLT_EPSILON; i++, decay *= keep)
+        job->out[0][i] = (float)(job->out[0][i] + decay * carry);
+}
+
+static void minmax_segment(void *arg, size_t segment)
+{
+    struct overlayjob_s *job = arg;
+    size_t begin, end, warm, i;
+    float lo, hi;
+    struct rollminmax_s r;
+
+    overlay_segment(job, segment, &begin, &end, &warm);
+    rollminmax_init(&r, job->window, job->scratch + (size_t)worker_index * job->scratch_bytes);
+    for(i = warm; i < begin; i++)
+        rollminmax_push(&r, job->values[i], &lo, &hi);
+    for(; i < end; i++)
+        rollminmax_push(&r, job->values[i], job->out[0] + i, job->out[1] + i);
+}
+
+static void pct_segment(void *arg, size_t segment)
+{
+    struct overlayjob_s *job = arg;
+    size_t begin, end, warm, i;
+    struct rollpct_s r;
+
+    overlay_segment(job, segment, &begin, &end, &warm);
+    rollpct_init(&r, job->window, job->scratch + (size_t)worker_index * job->scratch_bytes);
+    for(i = warm; i < begin; i++)
+        rollpct_push(&r, job->values[i]);
+    for(; i < end; i++) {
+        rollpct_push(&r, job->values[i]);
+        job->out[0][i] = rollpct_get(&r, 0.5);
+        job->out[1][i] = rollpct_get(&r, 0.99);
+    }
+}
+
+static float *add_overlay(struct graphdata_s *data, const char *name, unsigned color)
+{
+    struct overlay_s *overlay = data->overlays + data->num_overlays++;
+    overlay->name = name;
+    overlay->color = color;
+    overlay->values = arena_alloc(data->arena, sizeof(float) * data->size);
+    return overlay->values;
+}
+
+/* runs func over the segments with bytes of per-worker scratch */
+static void run_overlay(struct graphdata_s *data, struct overlayjob_s *job, size_t bytes, void (*func)(void *arg, size_t index))
+{
+    job->scratch_bytes = (bytes + 63) & ~(size_t)63;
+    job->scratch = arena_alloc(data->arena, job->scratch_bytes * (size_t)pool_width());
+    pool_parallel_for(job->num_segments, func, job);
+    arena_free(data->arena, job->scratch);
+}
+
+/* the ma:, ewma:, minmax: and pct: tags */
+static void compute_overlays(struct graphdata_s *data)
+{
+    size_t s, len;
+    double start = now_seconds();
+    struct overlayjob_s job;
+
+    data->num_overlays = 0;
+    if(!data->size || !(data->ma_window || data->ewma_alpha > 0.0f || data->minmax_window || data->pct_window))
+        return;
+
+    job.values = flat_samples(data);
+    job.size = data->size;
+    job.num_segments = pool_width() > 1 ? (size_t)pool_width() * 4 : 1;
+    if(job.num_segments > MAX_TASKS)
+        job.num_segments = MAX_TASKS;
+    if(job.num_segments > job.size)
+        job.num_segments = job.size;
+
+    if(data->ma_window) {
+        job.window = data->ma_window < data->size ? data->ma_window : data->size;
+        job.out[0] = add_overlay(data, "ma", 0xFFFF00);
+        run_overlay(data, &job, sizeof(double) * ((job.window > PREFIX_BLOCK ? job.window : PREFIX_BLOCK) + job.window + 1), &ma_segment);
+    }
+
+    if(data->ewma_alpha > 0.0f) {
+        job.alpha = data->ewma_alpha;
+        job.out[0] = add_overlay(data, "ewma", 0x00FFFF);
+        job.carry = arena_alloc(data->arena, sizeof(double) * 2 * job.num_segments);
+        pool_parallel_for(job.num_segments, &ewma_segment, &job);
+
+        /* starts as if the sample before the first equalled it */
+        job.carry[1] = job.values[0];
+        for(s = 1; s < job.num_segments; s++) {
+            len = (s * job.size / job.num_segments) - ((s - 1) * job.size / job.num_segments);
+            job.carry[s * 2 + 1] = job.carry[s * 2 - 2] + pow(1.0 - job.alpha, (double)len) * job.carry[s * 2 - 1];
+        }
+        pool_parallel_for(job.num_segments, &ewma_fixup, &job);
+        arena_free(data->arena, job.carry);
+    }
+
+    if(data->minmax_window) {
+        job.window = data->minmax_window < data->size ? data->minmax_window : data->size;
+        job.out[0] = add_overlay(data, "min", 0x4080FF);
+        job.out[1] = add_overlay(data, "max", 0xFF4040);
+        run_overlay(data, &job, rollminmax_bytes(job.window), &minmax_segment);
+    }
+
+    if(data->pct_window) {
+        job.window = data->pct_window < data->size ? data->pct_window : data->size;
+        job.out[0] = add_overlay(data, "p50", 0xFFFFFF);
+        job.out[1] = add_overlay(data, "p99", 0xFF00FF);
+        run_overlay(data, &job, rollpct_bytes(job.window), &pct_segment);
+    }
+    release_flat(data, job.values);
+
+    lprintf("overlays: %d series in %.1f ms on %zu segment(s)\n", data->num_overlays,
+        (now_seconds() - start) * 1000.0, job.num_segments);
+}
+
+struct histjob_s {
+    const struct graphdata_s *data;
+    size_t bins;
+    float scale;
+    uint32_t *counts;
+    float *scratch;
+};
+
+/* a bin per lane keeps runs of equal samples from queueing on one counter;
+ * the extra bin at the end takes the nans */
+static void bin_blocks(void *arg, size_t first, size_t last)
+{
+    struct histjob_s *job = arg;
+    size_t i, block, count, stride = job->bins + 1;
+    uint32_t *counts = job->counts + (size_t)worker_index * HIST_LANES * stride;
+    float *scratch = job->scratch + (size_t)worker_index * SAMPLES_PER_BLOCK;
+    float f, lo = job->data->min_value, top = (float)(job->bins - 1);
+    const float *values;
+#if UNDGRAPH_SSE2
+    int index[4];
+    __m128 v, vlo = _mm_set1_ps(lo), vscale = _mm_set1_ps(job->scale);
+    __m128 vtop = _mm_set1_ps(top), zero = _mm_setzero_ps();
+    __m128i nan, vi, vnan = _mm_set1_epi32((int)job->bins);
+#endif
+
+    for(block = first; block < last; block++) {
+        values = get_block(job->data, block, scratch, &count);
+        i = 0;
+#if UNDGRAPH_SSE2
+        for(; i + 4 <= count; i += 4) {
+            v = _mm_loadu_ps(values + i);
+            nan = _mm_castps_si128(_mm_cmpunord_ps(v, v));
+            v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(v, vlo), vscale), zero), vtop);
+            vi = _mm_cvttps_epi32(v);
+            vi = _mm_or_si128(_mm_andnot_si128(nan, vi), _mm_and_si128(nan, vnan));
+            _mm_storeu_si128((__m128i *)index, vi);
+            counts[index[0]]++;
+            counts[stride + index[1]]++;
+            counts[stride * 2 + index[2]]++;
+            counts[stride * 3 + index[3]]++;
+        }
+#endif
+        for(; i < count; i++) {
+            if(isnan(values[i])) {
+                counts[job->bins]++;
+                continue;
+            }
+            f = (values[i] - lo) * job->scale;
+            f = f > 0.0f ? f : 0.0f;
+            f = f < top ? f : top;
+            counts[(size_t)f]++;
+        }
+    }
+}
+
+/* the hist:N tag; bin edges split [min_value, max_value] evenly */
+static void compute_histogram(struct graphdata_s *data)
+{
+    size_t b, k, stride;
+    double start = now_seconds();
+    struct histjob_s job;
+    struct nodejob_s nodes;
+
+    if(data->hist_bins > MAX_BINS)
+        data->hist_bins = MAX_BINS;
+
+    job.data = data;
+    job.bins = data->hist_bins;
+    job.scale = data->max_value > data->min_value ? (float)((double)job.bins / ((double)data->max_value - (double)data->min_value)) : 0.0f;
+    stride = job.bins + 1;
+
+    data->histogram = arena_alloc(data->arena, sizeof(size_t) * stride);
+    job.counts = arena_alloc(data->arena, sizeof(uint32_t) * HIST_LANES * stride * (size_t)pool_width());
+    job.scratch = arena_alloc(data->arena, sizeof(float) * SAMPLES_PER_BLOCK * (size_t)pool_width());
+    memset(job.counts, 0, sizeof(uint32_t) * HIST_LANES * stride * (size_t)pool_width());
+
+    pool_for_nodes(&nodes, count_blocks(data), sizeof(float) * SAMPLES_PER_BLOCK, &bin_blocks, &job);
+
+    for(b = 0; b < stride; b++)
+        for(data->histogram[b] = 0, k = 0; k < HIST_LANES * (size_t)pool_width(); k++)
+            data->histogram[b] += job.counts[k * stride + b];
+
+    arena_free(data->arena, job.scratch);
+
+    lprintf("histogram: %zu bins over [%g, %g], %zu nan(s), in %.1f ms\n", job.bins, data->min_value,
+        data->max_value, data->histogram[job.bins], (now_seconds() - start) * 1000.0);
+}
+
+struct columnjob_s {
+    const struct graphdata_s *data;
+    float *scratch;
+    float *lo;
+    float *hi;
+    double *sum;
+    size_t *count;
+};
+
+/* column c holds the samples i with i * ENVELOPE_COLUMNS / size == c; each
+ * worker reduces the runs of its blocks into its own set of columns */
+static void reduce_columns(void *arg, size_t first, size_t last)
+{
+    struct columnjob_s *job = arg;
+    const struct graphdata_s *data = job->data;
+    size_t block, count, i, j, c, end, run;
+    size_t offset = (size_t)worker_index * ENVELOPE_COLUMNS;
+    float *scratch = job->scratch + (size_t)worker_index * SAMPLES_PER_BLOCK;
+    float lo, hi;
+    double sum;
+    const float *values;
+
+    for(block = first; block < last; block++) {
+        values = get_block(data, block, scratch, &count);
+        for(j = 0, i = block * SAMPLES_PER_BLOCK; j < count; j += run, i += run) {
+            c = (size_t)((uint64_t)i * ENVELOPE_COLUMNS / data->size);
+            end = (size_t)(((uint64_t)(c + 1) * data->size + ENVELOPE_COLUMNS - 1) / ENVELOPE_COLUMNS);
+            run = end - i < count - j ? end - i : count - j;
+
+            reduce_minmax(values + j, run, &lo, &hi);
+            job->lo[offset + c] = lo < job->lo[offset + c] ? lo : job->lo[offset + c];
+            job->hi[offset + c] = hi > job->hi[offset + c] ? hi : job->hi[offset + c];
+            for(sum = 0.0, end = j; end < j + run; end++) {
+                if(!isnan(values[end])) {
+                    sum += values[end];
+                    job->count[offset + c]++;
+                }
+            }
+            job->sum[offset + c] += sum;
+        }
+    }
+}
+
+struct alertjob_s {
+    struct graphdata_s *data;
+    const float *values;
+    size_t halo;
+};
+
+static void alert_blocks(void *arg, size_t first, size_t last)
+{
+    struct alertjob_s *job = arg;
+    size_t lo = first * SAMPLES_PER_BLOCK, hi = last * SAMPLES_PER_BLOCK, halo;
+    float min_value, max_value;
+    struct alertscan_s scan;
+
+    if(hi > job->data->size)
+        hi = job->data->size;
+    if(lo >= hi)
+        return;
+
+    halo = lo < job->halo ? lo : job->halo;
+    init_scan(&scan, &job->data->alerts, &job->data->alert_list);
+    scan.index = lo;
+    scan_alerts(&scan, job->values + lo, hi - lo, job->values + lo - halo, halo, &min_value, &max_value);
+    flush_hits(&scan);
+}
+
+/* the loaders that take min and max from a block index never see the
+ * values, so the rules get a pass of their own there */
+static void compute_alerts(struct graphdata_s *data)
+{
+    struct alertjob_s job;
+    struct nodejob_s nodes;
+
+    job.data = data;
+    job.values = flat_samples(data);
+    job.halo = alert_halo(&data->alerts);
+    start_alerts(data);
+    pool_for_nodes(&nodes, count_blocks(data), sizeof(float) * SAMPLES_PER_BLOCK, &alert_blocks, &job);
+    release_flat(data, job.values);
+    data->alerts_scanned = 1;
+}
+
+static int compare_runs(const void *a, const void *b)
+{
+    const struct alertrun_s *x = a, *y = b;
+    if(x->first != y->first)
+        return x->first < y->first ? -1 : 1;
+    return x->rule - y->rule;
+}
+
+/* puts the runs in order and joins the ones the scans cut apart */
+static void finish_alerts(struct graphdata_s *data)
+{
+    int k;
+    size_t i, n = 0;
+    struct alertlist_s *list = &data->alert_list;
+    struct alertrun_s *open[NUM_RULES] = { NULL };
+    struct alertrun_s *run;
+
+    mutex_destroy(&list->lock);
+    qsort(list->runs, list->count, sizeof(struct alertrun_s), &compare_runs);
+    for(i = 0; i < list->count; i++) {
+        run = list->runs + i;
+        k = run->rule;
+        if(open[k] && open[k]->last + 1 == run->first) {
+            open[k]->last = run->last;
+            if(k == RULE_BELOW ? run->peak < open[k]->peak : run->peak > open[k]->peak)
+                open[k]->peak = run->peak;
+            continue;
+        }
+        list->runs[n] = *run;
+        open[k] = list->runs + n++;
+    }
+    list->count = n;
+}
+
+static const char *rule_names[NUM_RULES] = { "above", "below", "slope", "sigma" };
+
+static float rule_limit(const struct alerts_s *alerts, int rule)
+{
+    switch(rule) {
+        case RULE_ABOVE: return alerts->above;
+        case RULE_BELOW: return alerts->below;
+        case RULE_SLOPE: return alerts->slope;
+        default: return alerts->sigma;
+    }
+}
+
+static void print_run(FILE *fp, const char *filename, const struct alerts_s *alerts, const struct alertrun_s *run)
+{
+    fprintf(fp, "%s: %s %g at %zu..%zu, peak %g\n", filename, rule_names[run->rule], rule_limit(alerts, run->rule),
+        run->first, run->last, run->peak);
+}
+
+/* every run goes to --alerts FILE, the first MAX_REPORTED to stdout */
+static void report_alerts(const struct graphdata_s *data, const char *filename)
+{
+    size_t i;
+    const struct alertlist_s *list = &data->alert_list;
+
+    for(i = 0; i < list->count; i++) {
+        if(i < MAX_REPORTED)
+            print_run(stdout, filename, &data->alerts, list->runs + i);
+        if(alert_file)
+            print_run(alert_file, filename, &data->alerts, list->runs + i);
+    }
+    if(alert_file)
+        fflush(alert_file);
+    lprintf("%s: %zu alert run(s)%s\n", filename, list->count, list->dropped ? ", more dropped" : "");
+}
+
+/* the envelope:1 tag; per column low, high and mean, one column per pixel */
+static void compute_envelope(struct graphdata_s *data)
+{
+    size_t c, k, n = ENVELOPE_COLUMNS * (size_t)pool_width();
+    double start = now_seconds(), sum;
+    size_t count;
+    struct columnjob_s job;
+    struct nodejob_s nodes;
+    float *lo, *hi, *mean;
+
+    data->columns = arena_alloc(data->arena, sizeof(float) * ENVELOPE_COLUMNS * 3);
+    lo = data->columns;
+    hi = lo + ENVELOPE_COLUMNS;
+    mean = hi + ENVELOPE_COLUMNS;
+
+    job.data = data;
+    job.lo = arena_alloc(data->arena, sizeof(float) * n * 2);
+    job.hi = job.lo + n;
+    job.sum = arena_alloc(data->arena, sizeof(double) * n);
+    job.count = arena_alloc(data->arena, sizeof(size_t) * n);
+    job.scratch = arena_alloc(data->arena, sizeof(float) * SAMPLES_PER_BLOCK * (size_t)pool_width());
+    for(c = 0; c < n; c++) {
+        job.lo[c] = FLT_MAX;
+        job.hi[c] = -FLT_MAX;
+        job.sum[c] = 0.0;
+        job.count[c] = 0;
+    }
+
+    pool_for_nodes(&nodes, count_blocks(data), sizeof(float) * SAMPLES_PER_BLOCK, &reduce_columns, &job);
+
+    for(c = 0; c < ENVELOPE_COLUMNS; c++) {
+        lo[c] = FLT_MAX;
+        hi[c] = -FLT_MAX;
+        for(sum = 0.0, count = 0, k = c; k < n; k += ENVELOPE_COLUMNS) {
+            lo[c] = job.lo[k] < lo[c] ? job.lo[k] : lo[c];
+            hi[c] = job.hi[k] > hi[c] ? job.hi[k] : hi[c];
+            sum += job.sum[k];
+            count += job.count[k];
+        }
+        mean[c] = count ? (float)(sum / (double)count) : 0.0f;
+
+        /* with fewer samples than columns some get none; they repeat the
+         * one before so the band does not dip to the edges */
+        if(lo[c] > hi[c] && c) {
+            lo[c] = lo[c - 1];
+            hi[c] = hi[c - 1];
+            mean[c] = mean[c - 1];
+        }
+    }
+
+    arena_free(data->arena, job.scratch);
+
+    lprintf("envelope: %d columns in %.1f ms\n", ENVELOPE_COLUMNS, (now_seconds() - start) * 1000.0);
+}
+
+/* bit reversal, the hann window and per stage twiddles, from the stage
+ * with two butterflies per group on: 8 floats per pair of butterflies,
+ * the real parts twice and the imaginary parts with alternating sign */
+static void plan_fft(struct fftplan_s *plan, size_t length, struct arena_s *arena)
+{
+    size_t i, j, h, n = 1;
+    unsigned bits = 0;
+    float *w;
+
+    while(n < length) {
+        n <<= 1;
+        bits++;
+    }
+    plan->n = n;
+    plan->length = length;
+    plan->rev = arena_alloc(arena, sizeof(uint32_t) * n);
+    plan->window = arena_alloc(arena, sizeof(float) * length);
+    plan->twiddles = arena_alloc(arena, sizeof(float) * 4 * n);
+
+    for(i = 0; i < n; i++) {
+        for(plan->rev[i] = 0, j = 0; j < bits; j++)
+            plan->rev[i] |= (uint32_t)((i >> j) & 1) << (bits - 1 - j);
+    }
+
+    for(plan->window_power = 0.0, i = 0; i < length; i++) {
+        plan->window[i] = (float)(0.5 - 0.5 * cos(2.0 * PI * (double)i / (double)(length > 1 ? length - 1 : 1)));
+        plan->window_power += (double)plan->window[i] * plan->window[i];
+    }
+
+    for(w = plan->twiddles, h = 2; h < n; h <<= 1) {
+        for(j = 0; j < h; j += 2, w += 8) {
+            w[0] = w[1] = (float)cos(PI * (double)j / (double)h);
+            w[2] = w[3] = (float)cos(PI * (double)(j + 1) / (double)h);
+            w[5] = (float)-sin(PI * (double)j / (double)h);
+            w[4] = -w[5];
+            w[7] = (float)-sin(PI * (double)(j + 1) / (double)h);
+            w[6] = -w[7];
+        }
+    }
+}
+
+/* in place radix-2 decimation in time over interleaved complex values
+ * that are already in bit reversed order */
+static void run_fft(const struct fftplan_s *plan, float *x)
+{
+    size_t i, j, h, n = plan->n;
+    const float *w, *tw = plan->twiddles;
+    float ar, ai, br, bi;
+#if UNDGRAPH_SSE2
+    __m128 a, b, t;
+#else
+    float tr, ti;
+    size_t k;
+#endif
+
+    for(i = 0; i < n * 2; i += 4) {
+        ar = x[i];
+        ai = x[i + 1];
+        br = x[i + 2];
+        bi = x[i + 3];
+        x[i] = ar + br;
+        x[i + 1] = ai + bi;
+        x[i + 2] = ar - br;
+        x[i + 3] = ai - bi;
+    }
+
+    for(h = 2; h < n; tw += h * 4, h <<= 1) {
+        for(i = 0; i < n; i += h * 2) {
+            for(j = 0, w = tw; j < h; j += 2, w += 8) {
+#if UNDGRAPH_SSE2
+                a = _mm_loadu_ps(x + (i + j) * 2);
+                b = _mm_loadu_ps(x + (i + j + h) * 2);
+                t = _mm_add_ps(_mm_mul_ps(b, _mm_loadu_ps(w)),
+                    _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)), _mm_loadu_ps(w + 4)));
+                _mm_storeu_ps(x + (i + j) * 2, _mm_add_ps(a, t));
+                _mm_storeu_ps(x + (i + j + h) * 2, _mm_sub_ps(a, t));
+#else
+                for(k = 0; k < 2; k++) {
+                    br = x[(i + j + h + k) * 2];
+                    bi = x[(i + j + h + k) * 2 + 1];
+                    tr = br * w[k * 2] + bi * w[4 + k * 2];
+                    ti = bi * w[k * 2 + 1] + br * w[5 + k * 2];
+                    x[(i + j + h + k) * 2] = x[(i + j + k) * 2] - tr;
+                    x[(i + j + h + k) * 2 + 1] = x[(i + j + k) * 2 + 1] - ti;
+                    x[(i + j + k) * 2] += tr;
+                    x[(i + j + k) * 2 + 1] += ti;
+                }
+#endif
+            }
+        }
+    }
+}
+
+struct spectrumjob_s {
+    const struct fftplan_s *plan;
+    const float *values;
+    size_t num_segments;
+    size_t hop;
+    size_t num_pairs;
+    size_t num_tasks;
+    float *scratch;
+    double *power;
+};
+
+/* windowed segment minus its mean, into the real or imaginary lane */
+static void load_segment(const struct spectrumjob_s *job, size_t segment, float *x, size_t lane)
+{
+    size_t i;
+    double mean = 0.0;
+    const struct fftplan_s *plan = job->plan;
+    const float *values = job->values + segment * job->hop;
+
+    for(i = 0; i < plan->length; i++)
+        mean += values[i];
+    mean /= (double)plan->length;
+    for(i = 0; i < plan->length; i++)
+        x[plan->rev[i] * 2 + lane] = (float)((double)values[i] - mean) * plan->window[i];
+}
+
+/* two real segments share one complex transform and are pulled apart
+ * by the symmetry of their spectra */
+static void spectrum_task(void *arg, size_t task)
+{
+    struct spectrumjob_s *job = arg;
+    const struct fftplan_s *plan = job->plan;
+    size_t k, pair, n = plan->n;
+    float *x = job->scratch + (size_t)worker_index * n * 2;
+    double *power = job->power + (size_t)worker_index * (n / 2 + 1);
+    double zr, zi, mr, mi;
+
+    for(pair = task * job->num_pairs / job->num_tasks; pair < (task + 1) * job->num_pairs / job->num_tasks; pair++) {
+        memset(x, 0, sizeof(float) * n * 2);
+        load_segment(job, pair * 2, x, 0);
+        if(pair * 2 + 1 < job->num_segments)
+            load_segment(job, pair * 2 + 1, x, 1);
+        run_fft(plan, x);
+
+        for(k = 0; k <= n / 2; k++) {
+            zr = x[k * 2];
+            zi = x[k * 2 + 1];
+            mr = x[((n - k) & (n - 1)) * 2];
+            mi = -x[((n - k) & (n - 1)) * 2 + 1];
+            power[k] += ((zr + mr) * (zr + mr) + (zi + mi) * (zi + mi) + (zr - mr) * (zr - mr) + (zi - mi) * (zi - mi)) * 0.25;
+        }
+    }
+}
+
+/* the fft:N tag; welch averaged power over half overlapping hann windowed
+ * segments of N samples, in dB. shorter data is one zero padded segment */
+static void compute_spectrum(struct graphdata_s *data)
+{
+    size_t k, w, length = data->fft_size;
+    double start = now_seconds();
+    struct fftplan_s plan;
+    struct spectrumjob_s job;
+
+    if(length > MAX_FFT)
+        length = MAX_FFT;
+    if(length > data->size)
+        length = data->size;
+    if(length < 2)
+        return;
+
+    plan_fft(&plan, length, data->arena);
+    job.plan = &plan;
+    job.values = flat_samples(data);
+    job.hop = length / 2 ? length / 2 : 1;
+    job.num_segments = (data->size - length) / job.hop + 1;
+    job.num_pairs = (job.num_segments + 1) / 2;
+    job.num_tasks = pool_width() > 1 ? (size_t)pool_width() * 4 : 1;
+    if(job.num_tasks > MAX_TASKS)
+        job.num_tasks = MAX_TASKS;
+    if(job.num_tasks > job.num_pairs)
+        job.num_tasks = job.num_pairs;
+
+    data->spectrum_bins = plan.n / 2 + 1;
+    data->spectrum = arena_alloc(data->arena, sizeof(float) * data->spectrum_bins);
+    job.power = arena_alloc(data->arena, sizeof(double) * data->spectrum_bins * (size_t)pool_width());
+    job.scratch = arena_alloc(data->arena, sizeof(float) * plan.n * 2 * (size_t)pool_width());
+    memset(job.power, 0, sizeof(double) * data->spectrum_bins * (size_t)pool_width());
+
+    pool_parallel_for(job.num_tasks, &spectrum_task, &job);
+
+    for(w = 1; w < (size_t)pool_width(); w++)
+        for(k = 0; k < data->spectrum_bins; k++)
+            job.power[k] += job.power[w * data->spectrum_bins + k];
+    for(k = 0; k < data->spectrum_bins; k++)
+        data->spectrum[k] = (float)(10.0 * log10(job.power[k] / ((double)job.num_segments * plan.window_power) + 1e-30));
+
+    arena_free(data->arena, job.scratch);
+    release_flat(data, job.values);
+
+    lprintf("spectrum: %zu-point fft over %zu segment(s) of %zu in %.1f ms\n", plan.n, job.num_segments,
+        length, (now_seconds() - start) * 1000.0);
+}
+
+/* times the linear passes over malloc'd versus huge-page-backed arrays */
+static void run_bench(struct graphdata_s *data)
+{
+    int pass, round;
+    size_t i, count, bytes;
+    float lo, hi, *values[3];
+    float *saved = data->data;
+    vec2_t *mesh;
+    const float *block;
+    double start, reduce_time, mesh_time;
+    struct nodejob_s nodes;
+    static const char *names[3] = { "malloc", "big_alloc", "numa" };
+
+    bytes = sizeof(float) * data->size;
+    values[0] = malloc(bytes + 1);
+    values[1] = big_alloc(bytes);
+    values[2] = big_alloc(bytes);
+    assert(("Out of memory!", values[0]));
+
+    for(i = 0; i < count_blocks(data); i++) {
+        block = get_block(data, i, values[0] + i * SAMPLES_PER_BLOCK, &count);
+        memmove(values[0] + i * SAMPLES_PER_BLOCK, block, sizeof(float) * count);
+    }
+    memcpy(values[1], values[0], bytes);
+    copy_nodes(values[2], values[0], data->size, &nodes);
+
+    for(pass = 0; pass < 3; pass++) {
+        reduce_time = mesh_time = 0.0;
+        for(round = 0; round < BENCH_ROUNDS; round++) {
+            start = now_seconds();
+            if(pass == 2)
+                reduce_nodes(values[pass], data->size, &lo, &hi, &nodes);
+            else
+                reduce_minmax(values[pass], data->size, &lo, &hi);
+            reduce_time += now_seconds() - start;
+
+            mesh = pass ? big_alloc(sizeof(vec2_t) * data->size) : malloc(sizeof(vec2_t) * data->size + 1);
+            assert(("Out of memory!", mesh));
+            data->data = values[pass];
+            start = now_seconds();
+            build_mesh(data, NULL, mesh);
+            mesh_time += now_seconds() - start;
+            if(pass)
+                big_free(mesh, sizeof(vec2_t) * data->size);
+            else
+                free(mesh);
+        }
+
+        lprintf("bench: %-9s reduce %8.1f MiB/s, mesh %8.1f MiB/s (min %g, max %g)\n", names[pass],
+            (double)bytes * BENCH_ROUNDS / 1048576.0 / (reduce_time > 0.0 ? reduce_time : 1e-9),
+            (double)bytes * BENCH_ROUNDS / 1048576.0 / (mesh_time > 0.0 ? mesh_time : 1e-9), lo, hi);
+    }
+
+    /* the last reduction round */
+    print_node_stats("bench: numa", &nodes);
+
+    data->data = saved;
+    big_free(values[2], bytes);
+    big_free(values[1], bytes);
+    free(values[0]);
+}
+
+static int parse_args(int argc, char **argv, struct options_s *opts)
+{
+    int i;
+
+    opts->replay_speed = 1.0;
+    for(i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "--pack") && i + 1 < argc) {
+            opts->pack_filename = argv[++i];
+            continue;
+        }
+        if(!strcmp(argv[i], "--range") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%zu:%zu", &opts->range_begin, &opts->range_end) < 1) {
+                lprintf("--range: expected begin:end\n");
+                return 0;
+            }
+            continue;
+        }
+        if(!strcmp(argv[i], "--stride") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%zu", &opts->stride) != 1 || !opts->stride) {
+                lprintf("--stride: expected a positive step\n");
+                return 0;
+            }
+            continue;
+        }
+        if(!strcmp(argv[i], "--downsample") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%zu", &opts->downsample) != 1 || opts->downsample < 3) {
+                lprintf("--downsample: expected at least 3 points\n");
+                return 0;
+            }
+            continue;
+        }
+        if(!strcmp(argv[i], "--hist") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%zu", &opts->hist_bins) != 1 || !opts->hist_bins) {
+                lprintf("--hist: expected a number of bins\n");
+                return 0;
+            }
+            continue;
+        }
+        if(!strcmp(argv[i], "--fft") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%zu", &opts->fft_size) != 1 || opts->fft_size < 2) {
+                lprintf("--fft: expected a segment length of at least 2\n");
+                return 0;
+            }
+            continue;
+        }
+        if(!strcmp(argv[i], "--envelope")) {
+            opts->envelope = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--history") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%zu", &opts->history) != 1 || opts->history < 2) {
+                lprintf("--history: expected at least 2 buckets per tier\n");
+                return 0;
+            }
+            continue;
+        }
+        if(!strcmp(argv[i], "--record") && i + 1 < argc) {
+            opts->record_filename = argv[++i];
+            opts->follow = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--replay") && i + 1 < argc) {
+            opts->replay_filename = argv[++i];
+            opts->follow = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--fsync") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%zu", &opts->sync_every) != 1) {
+                lprintf("--fsync: expected a number of batches, 0 for never\n");
+                return 0;
+            }
+            continue;
+        }
+        if(!strcmp(argv[i], "--speed") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%lf", &opts->replay_speed) != 1 || opts->replay_speed < 0.0) {
+                lprintf("--speed: expected a factor, 0 for as fast as possible\n");
+                return 0;
+            }
+            continue;
+        }
+        if(!strcmp(argv[i], "--above") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%f", &opts->alerts.above) != 1) {
+                lprintf("--above: expected a value\n");
+                return 0;
+            }
+            opts->alerts.rules |= 1 << RULE_ABOVE;
+            continue;
+        }
+        if(!strcmp(argv[i], "--below") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%f", &opts->alerts.below) != 1) {
+                lprintf("--below: expected a value\n");
+                return 0;
+            }
+            opts->alerts.rules |= 1 << RULE_BELOW;
+            continue;
+        }
+        if(!strcmp(argv[i], "--slope") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%f", &opts->alerts.slope) != 1) {
+                lprintf("--slope: expected a step between samples\n");
+                return 0;
+            }
+            opts->alerts.rules |= 1 << RULE_SLOPE;
+            continue;
+        }
+        if(!strcmp(argv[i], "--sigma") && i + 1 < argc) {
+            if(!parse_sigma(argv[++i], &opts->alerts)) {
+                lprintf("--sigma: expected N or N:window\n");
+                return 0;
+            }
+            opts->alerts.rules |= 1 << RULE_SIGMA;
+            continue;
+        }
+        if(!strcmp(argv[i], "--alerts") && i + 1 < argc) {
+            opts->alerts_filename = argv[++i];
+            continue;
+        }
+        if(!strcmp(argv[i], "--diff") && i + 2 < argc) {
+            opts->diff_filenames[0] = argv[++i];
+            opts->diff_filenames[1] = argv[++i];
+            continue;
+        }
+        if(!strcmp(argv[i], "--animate") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%zu:%zu", &opts->anim_window, &opts->anim_step) < 1 || opts->anim_window < 2) {
+                lprintf("--animate: expected a window of at least 2 samples, and a step\n");
+                return 0;
+            }
+            continue;
+        }
+        if(!strcmp(argv[i], "--sheet") && i + 1 < argc) {
+            opts->sheet_filename = argv[++i];
+            continue;
+        }
+        if(!strcmp(argv[i], "--summary")) {
+            opts->summary = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--json")) {
+            opts->json = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--y4m")) {
+            opts->y4m = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--ratio")) {
+            opts->diff_ratio = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--check")) {
+            opts->check = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--axes")) {
+            opts->axes = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--cdf")) {
+            opts->cdf = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--follow")) {
+            opts->follow = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--index")) {
+            opts->build_index = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--batch")) {
+            opts->batch = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--bench")) {
+            opts->bench = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "--direct")) {
+            opts->direct_io = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "forcemsaa")) {
+            opts->force_msaa = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "forcesave")) {
+            opts->force_save = 1;
+            continue;
+        }
+        if(!strcmp(argv[i], "forcecompress")) {
+            opts->force_compress = 1;
+            continue;
+        }
+        if(argv[i][0] == '-' && argv[i][1] == '-') {
+            lprintf("unknown option: %s\n", argv[i]);
+            return 0;
+        }
+        opts->files[opts->num_files++] = argv[i];
+    }
+
+    if(opts->diff_filenames[0] && (opts->batch || opts->follow)) {
+        lprintf("--diff: not with --batch or --follow\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+static const char *bool_to_string(int value)
+{
+    if(value)
+        return "true";
+    return "false";
+}
+
+/* the font atlas, the quad program and its per instance attributes */
+static int init_axes_gl(void)
+{
+    int i, row, bit;
+    GLuint vs, fs;
+    unsigned char atlas[FONT_ATLAS_WIDTH * FONT_CELL] = { 0 };
+
+    for(i = 0; font_chars[i]; i++)
+        for(row = 0; row < FONT_HEIGHT; row++)
+            for(bit = 0; bit < FONT_WIDTH; bit++)
+                if(font_glyphs[i][row] & (0x10 >> bit))
+                    atlas[row * FONT_ATLAS_WIDTH + i * FONT_CELL + bit] = 0xFF;
+    for(row = 0; row < FONT_CELL; row++)
+        memset(atlas + row * FONT_ATLAS_WIDTH + FONT_SOLID * FONT_CELL, 0xFF, FONT_CELL);
+
+    vs = compile_shader(GL_VERTEX_SHADER, glsl_quad_v);
+    fs = compile_shader(GL_FRAGMENT_SHADER, glsl_quad_f);
+    if(!vs || !fs)
+        return 0;
+    glquadprogram = link_program(vs, fs);
+    glDeleteShader(fs);
+    glDeleteShader(vs);
+    if(!glquadprogram)
+        return 0;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &glfont);
+    glTextureStorage2D(glfont, 1, GL_R8, FONT_ATLAS_WIDTH, FONT_CELL);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage2D(glfont, 0, 0, 0, FONT_ATLAS_WIDTH, FONT_CELL, GL_RED, GL_UNSIGNED_BYTE, atlas);
+    glTextureParameteri(glfont, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(glfont, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(glfont, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(glfont, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glCreateBuffers(1, &glquadvbo);
+    glCreateVertexArrays(1, &glquadvao);
+    glVertexArrayVertexBuffer(glquadvao, 0, glquadvbo, 0, sizeof(struct quad_s));
+    glVertexArrayBindingDivisor(glquadvao, 0, 1);
+    glEnableVertexArrayAttrib(glquadvao, 0);
+    glEnableVertexArrayAttrib(glquadvao, 1);
+    glEnableVertexArrayAttrib(glquadvao, 2);
+    glVertexArrayAttribFormat(glquadvao, 0, 4, GL_FLOAT, GL_FALSE, offsetof(struct quad_s, rect));
+    glVertexArrayAttribFormat(glquadvao, 1, 4, GL_FLOAT, GL_FALSE, offsetof(struct quad_s, uv));
+    glVertexArrayAttribFormat(glquadvao, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(struct quad_s, color));
+    glVertexArrayAttribBinding(glquadvao, 0, 0);
+    glVertexArrayAttribBinding(glquadvao, 1, 0);
+    glVertexArrayAttribBinding(glquadvao, 2, 0);
+    return 1;
+}
+
+static void shutdown_axes_gl(void)
+{
+    glDeleteVertexArrays(1, &glquadvao);
+    glDeleteBuffers(1, &glquadvbo);
+    glDeleteTextures(1, &glfont);
+    glDeleteProgram(glquadprogram);
+}
+
+static int init_scroll_gl(void)
+{
+    GLuint vs = compile_shader(GL_VERTEX_SHADER, glsl_scroll_v);
+    GLuint fs = compile_shader(GL_FRAGMENT_SHADER, glsl_scroll_f);
+
+    if(!vs || !fs)
+        return 0;
+    glscrollprogram = link_program(vs, fs);
+    glDeleteShader(fs);
+    glDeleteShader(vs);
+    return glscrollprogram != 0;
+}
+
+/* the live plot texture, made once the follow view knows its width */
+static void create_scroll(int columns)
+{
+    glCreateTextures(GL_TEXTURE_2D, 1, &glscrolltex);
+    glTextureStorage2D(glscrolltex, 1, GL_RGBA8, columns, HEIGHT);
+    glTextureParameteri(glscrolltex, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(glscrolltex, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(glscrolltex, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(glscrolltex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glCreateFramebuffers(1, &glscrollfbo);
+    glNamedFramebufferTexture(glscrollfbo, GL_COLOR_ATTACHMENT0, glscrolltex, 0);
+}
+
+static void shutdown_scroll_gl(void)
+{
+    glDeleteFramebuffers(1, &glscrollfbo);
+    glDeleteTextures(1, &glscrolltex);
+    glDeleteProgram(glscrollprogram);
+}
+
+static int init_gl(const char *title, int msaa, int visible)
+{
+    GLuint vs, fs;
+
+    glfwSetErrorCallback(&on_glfw_error);
+    if(!glfwInit())
+        return 0;
+
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+    glfwWindowHint(GLFW_SAMPLES, msaa ? 4 : 0);
+
+    window = glfwCreateWindow(WIDTH, HEIGHT, title, NULL, NULL);
+    if(!window) {
+        glfwTerminate();
+        return 0;
+    }
+
+    glfwMakeContextCurrent(window);
+    if(!gladLoadGL(glfwGetProcAddress)) {
+        lprintf("gladLoadGL failed\n");
+        goto error;
+    }
+
+    lprintf("GL_VERSION: %s\n", glGetString(GL_VERSION));
+
+#if !UNDGRAPH_HAVE_ZLIB
+    /* glReadPixels hands the rows over bottom-up */
+    stbi_flip_vertically_on_write(1);
+#endif
+
+    vs = compile_shader(GL_VERTEX_SHADER, glsl_v);
+    fs = compile_shader(GL_FRAGMENT_SHADER, glsl_f);
+    if(!vs || !fs) {
+        lprintf("shader compilation failed\n");
+        goto error;
+    }
+
+    glprogram = link_program(vs, fs);
+    if(!glprogram) {
+        lprintf("program link failed\n");
+        goto error;
+    }
+
+    glDeleteShader(fs);
+    glDeleteShader(vs);
+
+    /* x scale and offset, only --animate pans */
+    glProgramUniform2f(glprogram, 1, 1.0f, 0.0f);
+
+    glCreateBuffers(1, &glvbo);
+    glCreateVertexArrays(1, &glvao);
+    glVertexArrayVertexBuffer(glvao, 0, glvbo, 0, sizeof(vec2_t));
+    glEnableVertexArrayAttrib(glvao, 0);
+    glVertexArrayAttribFormat(glvao, 0, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(glvao, 0, 0);
+
+    if(!init_axes_gl()) {
+        lprintf("axes setup failed\n");
+        goto error;
+    }
+
+    if(!init_scroll_gl()) {
+        lprintf("scroll setup failed\n");
+        goto error;
+    }
+
+    return 1;
+
+error:
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    window = NULL;
+    return 0;
+}
+
+static void shutdown_gl(void)
+{
+    shutdown_axes_gl();
+    shutdown_scroll_gl();
+    glDeleteVertexArrays(1, &glvao);
+    glDeleteBuffers(1, &glvbo);
+    glDeleteProgram(glprogram);
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    window = NULL;
+}
+
+static void add_strip(GLenum mode, size_t first, size_t count, unsigned color)
+{
+    struct glstrip_s *strip = glstrips + glnumstrips++;
+    strip->mode = mode;
+    strip->first = (GLint)first;
+    strip->count = (GLsizei)count;
+    strip->color = color;
+}
+
+static void add_quad(struct quad_s *quad, float x, float y, float w, float h, int cell, unsigned color)
+{
+    quad->rect[0] = x;
+    quad->rect[1] = y;
+    quad->rect[2] = w;
+    quad->rect[3] = h;
+
+    /* the solid cell is sampled in its middle, glyphs edge to edge with
+     * their top row first in the atlas */
+    if(cell == FONT_SOLID) {
+        quad->uv[0] = quad->uv[2] = ((float)cell * FONT_CELL + FONT_CELL * 0.5f) / (float)FONT_ATLAS_WIDTH;
+        quad->uv[1] = quad->uv[3] = 0.5f;
+    }
+    else {
+        quad->uv[0] = (float)(cell * FONT_CELL) / (float)FONT_ATLAS_WIDTH;
+        quad->uv[2] = (float)(cell * FONT_CELL + FONT_WIDTH) / (float)FONT_ATLAS_WIDTH;
+        quad->uv[1] = (float)FONT_HEIGHT / (float)FONT_CELL;
+        quad->uv[3] = 0.0f;
+    }
+
+    quad->color[0] = (unsigned char)(color >> 16);
+    quad->color[1] = (unsigned char)(color >> 8);
+    quad->color[2] = (unsigned char)color;
+    quad->color[3] = 0xFF;
+}
+
+static size_t add_label(struct quad_s *quads, size_t n, float x, float y, double value)
+{
+    char text[32];
+    const char *p, *glyph;
+
+    /* labels that would run off the frame are left out */
+    snprintf(text, sizeof(text), "%.6g", value);
+    if(x + (float)(strlen(text) * (FONT_WIDTH + 1) * LABEL_SCALE) > (float)WIDTH || y + FONT_HEIGHT * LABEL_SCALE > (float)HEIGHT)
+        return n;
+    for(p = text; *p && n < MAX_QUADS; p++, x += (FONT_WIDTH + 1) * LABEL_SCALE) {
+        glyph = strchr(font_chars, *p);
+        if(glyph)
+            add_quad(quads + n++, x, y, FONT_WIDTH * LABEL_SCALE, FONT_HEIGHT * LABEL_SCALE, (int)(glyph - font_chars), LABEL_COLOR);
+    }
+    return n;
+}
+
+/* gridlines and labels at nice steps of what the frame edges stand for,
+ * the horizontal ones from y_first up, then the two axis lines; returns
+ * the number of quads */
+static size_t build_axes(const struct axes_s *axes, float frame_px, double y_step, struct quad_s *quads)
+{
+    size_t n = 0;
+    double v, step;
+    float p, w = (float)WIDTH - frame_px * 2, h = (float)HEIGHT - frame_px * 2;
+
+    if(!(axes->x1 > axes->x0) || !(axes->y1 > axes->y0))
+        return 0;
+
+    step = y_step > 0.0 ? y_step : nice_step(axes->y1 - axes->y0, AXIS_TICKS);
+    for(v = ceil(axes->y_first / step) * step; v <= axes->y1 && n + 16 < MAX_QUADS; v += step) {
+        p = frame_px + (float)((v - axes->y0) / (axes->y1 - axes->y0)) * h;
+        add_quad(quads + n++, frame_px, p, w, 1.0f, FONT_SOLID, GRID_COLOR);
+        n = add_label(quads, n, frame_px + 4.0f, p + 3.0f, fabs(v) < step * 1e-9 ? 0.0 : v);
+    }
+
+    step = nice_step(axes->x1 - axes->x0, AXIS_TICKS);
+    for(v = ceil(axes->x0 / step) * step; v <= axes->x1 && n + 16 < MAX_QUADS; v += step) {
+        p = frame_px + (float)((v - axes->x0) / (axes->x1 - axes->x0)) * w;
+        add_quad(quads + n++, p, frame_px, 1.0f, h, FONT_SOLID, GRID_COLOR);
+        n = add_label(quads, n, p + 3.0f, frame_px + 4.0f, fabs(v) < step * 1e-9 ? 0.0 : v);
+    }
+
+    add_quad(quads + n++, frame_px, frame_px, w, 1.0f, FONT_SOLID, AXIS_COLOR);
+    add_quad(quads + n++, frame_px, frame_px, 1.0f, h, FONT_SOLID, AXIS_COLOR);
+    return n;
+}
+
+static void set_axes(double x0, double x1, double y0, double y1, double y_step)
+{
+    glaxes.x0 = x0;
+    glaxes.x1 = x1;
+    glaxes.y0 = y0;
+    glaxes.y1 = y1;
+    glaxes.y_step = y_step;
+    glaxes.y_first = y0;
+}
+
+/* the axes:1 tag; glaxes was set by the view that was just uploaded */
+static void upload_axes(const struct graphdata_s *data)
+{
+    struct quad_s *quads;
+
+    glnumquads = 0;
+    if(!data->axes)
+        return;
+
+    quads = arena_alloc(data->arena, sizeof(struct quad_s) * MAX_QUADS);
+    glnumquads = (GLsizei)build_axes(&glaxes, data->frame_px, glaxes.y_step, quads);
+    glNamedBufferData(glquadvbo, sizeof(struct quad_s) * (size_t)glnumquads, quads, GL_STREAM_DRAW);
+    arena_free(data->arena, quads);
+}
+
+/* the overlays go after first in the buffer, one sample wide each */
+static void upload_overlays(const struct graphdata_s *data, size_t first)
+{
+    int k;
+    vec2_t *mesh;
+
+    if(!data->num_overlays)
+        return;
+
+    mesh = arena_alloc(data->arena, sizeof(vec2_t) * data->size);
+    for(k = 0; k < data->num_overlays; k++) {
+        build_mesh(data, data->overlays[k].values, mesh);
+        glNamedBufferSubData(glvbo, sizeof(vec2_t) * (first + data->size * (size_t)k), sizeof(vec2_t) * data->size, mesh);
+        add_strip(GL_LINE_STRIP, first + data->size * (size_t)k, data->size, data->overlays[k].color);
+    }
+    arena_free(data->arena, mesh);
+}
+
+/* a vertical line where each alert run starts, a strip per rule; first
+ * is where they go in the buffer, after the overlays */
+static size_t marker_vertices(const struct graphdata_s *data)
+{
+    size_t n = data->alert_list.count < MAX_MARKERS ? data->alert_list.count : MAX_MARKERS;
+    return n * 2;
+}
+
+static void upload_markers(const struct graphdata_s *data, size_t first)
+{
+    int k;
+    size_t i, n, start, total = marker_vertices(data) / 2;
+    float x0 = data->frame_px, w = (float)WIDTH - data->frame_px * 2;
+    vec2_t *mesh;
+
+    if(!total)
+        return;
+
+    mesh = arena_alloc(data->arena, sizeof(vec2_t) * total * 2);
+    for(k = 0, n = 0; k < NUM_RULES; k++) {
+        for(i = 0, start = n; i < total; i++) {
+            if(data->alert_list.runs[i].rule != k)
+                continue;
+            mesh[n * 2][0] = mesh[n * 2 + 1][0] = x0 + (float)data->alert_list.runs[i].first * w / (float)data->size;
+            mesh[n * 2][1] = x0;
+            mesh[n * 2 + 1][1] = (float)HEIGHT - x0;
+            n++;
+        }
+        if(n > start)
+            add_strip(GL_LINES, first + start * 2, (n - start) * 2, marker_colors[k]);
+    }
+    glNamedBufferSubData(glvbo, sizeof(vec2_t) * first, sizeof(vec2_t) * total * 2, mesh);
+    arena_free(data->arena, mesh);
+}
+
+/* the bins as a step line, then the cdf rising from 0 to 1 across the
+ * height; both are scaled to the frame like the series */
+static void upload_histogram(const struct graphdata_s *data)
+{
+    size_t b, peak = 1, total = 0, bins = data->hist_bins;
+    float x0 = data->frame_px, w = (float)WIDTH - data->frame_px * 2, h = (float)HEIGHT - data->frame_px * 2;
+    vec2_t *mesh = arena_alloc(data->arena, sizeof(vec2_t) * (bins * 3 + 1));
+    vec2_t *cdf = mesh + bins * 2;
+
+    for(b = 0; b < bins; b++) {
+        peak = data->histogram[b] > peak ? data->histogram[b] : peak;
+        total += data->histogram[b];
+    }
+
+    cdf[0][0] = x0;
+    cdf[0][1] = data->frame_px;
+    for(b = 0; b < bins; b++) {
+        mesh[b * 2][0] = x0 + (float)b * w / (float)bins;
+        mesh[b * 2 + 1][0] = x0 + (float)(b + 1) * w / (float)bins;
+        mesh[b * 2][1] = mesh[b * 2 + 1][1] = data->frame_px + (float)data->histogram[b] / (float)peak * h;
+        cdf[b + 1][0] = mesh[b * 2 + 1][0];
+        cdf[b + 1][1] = cdf[b][1] + (total ? (float)data->histogram[b] / (float)total * h : 0.0f);
+    }
+
+    set_axes(data->min_value, data->max_value, 0.0, (double)peak, 0.0);
+    glNamedBufferData(glvbo, sizeof(vec2_t) * (bins * 3 + 1), mesh, GL_STATIC_DRAW);
+    add_strip(GL_LINE_STRIP, 0, bins * 2, SERIES_COLOR);
+    if(data->cdf)
+        add_strip(GL_LINE_STRIP, bins * 2, bins + 1, CDF_COLOR);
+    arena_free(data->arena, mesh);
+}
+
+/* frequency from 0 to half the sample rate across, the top
+ * SPECTRUM_RANGE_DB of the power up */
+static void upload_spectrum(const struct graphdata_s *data)
+{
+    size_t k, bins = data->spectrum_bins;
+    float peak = -FLT_MAX, y;
+    float x0 = data->frame_px, w = (float)WIDTH - data->frame_px * 2, h = (float)HEIGHT - data->frame_px * 2;
+    vec2_t *mesh = arena_alloc(data->arena, sizeof(vec2_t) * bins);
+
+    for(k = 0; k < bins; k++)
+        peak = data->spectrum[k] > peak ? data->spectrum[k] : peak;
+
+    for(k = 0; k < bins; k++) {
+        y = (data->spectrum[k] - (peak - SPECTRUM_RANGE_DB)) / SPECTRUM_RANGE_DB;
+        mesh[k][0] = x0 + (float)k * w / (float)(bins - 1);
+        mesh[k][1] = x0 + (y > 0.0f ? y : 0.0f) * h;
+    }
+
+    set_axes(0.0, 0.5, (double)peak - SPECTRUM_RANGE_DB, (double)peak, 0.0);
+    glNamedBufferData(glvbo, sizeof(vec2_t) * bins, mesh, GL_STATIC_DRAW);
+    add_strip(GL_LINE_STRIP, 0, bins, SERIES_COLOR);
+    arena_free(data->arena, mesh);
+    lprintf("spectrum: peak %.1f dB\n", peak);
+}
+
+/* a triangle strip from the low to the high end of every column, the
+ * mean through the middle of the columns on top */
+static void upload_envelope(const struct graphdata_s *data)
+{
+    size_t c, total = ENVELOPE_COLUMNS * 3 + data->size * (size_t)data->num_overlays + marker_vertices(data);
+    float x0 = data->frame_px, w = (float)WIDTH - data->frame_px * 2, h = (float)HEIGHT - data->frame_px * 2;
+    const float *lo = data->columns, *hi = lo + ENVELOPE_COLUMNS, *mean = hi + ENVELOPE_COLUMNS;
+    vec2_t *mesh = arena_alloc(data->arena, sizeof(vec2_t) * ENVELOPE_COLUMNS * 3);
+
+    for(c = 0; c < ENVELOPE_COLUMNS; c++) {
+        mesh[c * 2][0] = mesh[c * 2 + 1][0] = mesh[ENVELOPE_COLUMNS * 2 + c][0] = x0 + ((float)c + 0.5f) * w / (float)ENVELOPE_COLUMNS;
+        mesh[c * 2][1] = x0 + lo[c] / data->max_value * h;
+        mesh[c * 2 + 1][1] = x0 + hi[c] / data->max_value * h;
+        mesh[ENVELOPE_COLUMNS * 2 + c][1] = x0 + mean[c] / data->max_value * h;
+    }
+
+    set_axes(0.0, (double)data->size, 0.0, data->max_value, data->tick_size);
+    glNamedBufferData(glvbo, sizeof(vec2_t) * total, NULL, GL_STATIC_DRAW);
+    glNamedBufferSubData(glvbo, 0, sizeof(vec2_t) * ENVELOPE_COLUMNS * 3, mesh);
+    add_strip(GL_TRIANGLE_STRIP, 0, ENVELOPE_COLUMNS * 2, ENVELOPE_COLOR);
+    if(data->envelope_mean)
+        add_strip(GL_LINE_STRIP, ENVELOPE_COLUMNS * 2, ENVELOPE_COLUMNS, SERIES_COLOR);
+    arena_free(data->arena, mesh);
+
+    upload_overlays(data, ENVELOPE_COLUMNS * 3);
+    upload_markers(data, ENVELOPE_COLUMNS * 3 + data->size * (size_t)data->num_overlays);
+}
+
+static void upload_series(const struct graphdata_s *data)
+{
+    size_t i, count;
+    size_t *picked;
+    const float *values;
+    vec2_t *mesh;
+
+    /* lttb:N keeps the x position of every point it picks */
+    if(data->lttb && data->lttb < data->size) {
+        picked = arena_alloc(data->arena, sizeof(size_t) * data->lttb);
+        mesh = arena_alloc(data->arena, sizeof(vec2_t) * data->lttb);
+        count = downsample_lttb(data, data->lttb, picked);
+        values = flat_samples(data);
+        for(i = 0; i < count; i++) {
+            mesh[i][0] = (float)data->frame_px + (float)picked[i] * (float)(WIDTH - data->frame_px * 2) / (float)data->size;
+            mesh[i][1] = (float)data->frame_px + values[picked[i]] / data->max_value * (float)(HEIGHT - data->frame_px * 2);
+        }
+        release_flat(data, values);
+    }
+    else {
+        mesh = arena_alloc(data->arena, sizeof(vec2_t) * data->size);
+        build_mesh(data, NULL, mesh);
+        count = data->size;
+    }
+
+    /* the overlays follow the samples in the same buffer */
+    glNamedBufferData(glvbo, sizeof(vec2_t) * (count + data->size * (size_t)data->num_overlays + marker_vertices(data)), NULL, GL_STATIC_DRAW);
+    glNamedBufferSubData(glvbo, 0, sizeof(vec2_t) * count, mesh);
+    add_strip(GL_LINE_STRIP, 0, count, SERIES_COLOR);
+    arena_free(data->arena, mesh);
+    set_axes(0.0, (double)data->size, 0.0, data->max_value, data->tick_size);
+
+    upload_overlays(data, count);
+    upload_markers(data, count + data->size * (size_t)data->num_overlays);
+}
+
+struct diffmeshjob_s {
+    const float *series[3];
+    float base[3];
+    float center[3];
+    float scale[3];
+    size_t size;
+    size_t num_segments;
+    float x0;
+    float w;
+    vec2_t *mesh;
+};
+
+static void diff_mesh_segment(void *arg, size_t segment)
+{
+    struct diffmeshjob_s *job = arg;
+    size_t i, k, first = segment * job->size / job->num_segments, last = (segment + 1) * job->size / job->num_segments;
+    vec2_t *mesh;
+
+    for(k = 0; k < 3; k++) {
+        mesh = job->mesh + k * job->size;
+        for(i = first; i < last; i++) {
+            mesh[i][0] = job->x0 + (float)i * job->w / (float)job->size;
+            mesh[i][1] = job->base[k] + (job->series[k][i] - job->center[k]) * job->scale[k];
+        }
+    }
+}
+
+/* a and b on one scale above, the delta (or b over a) around its zero
+ * (or one) line in the panel under them; all of it in one buffer */
+static void upload_diff(const struct graphdata_s *data)
+{
+    int k;
+    size_t n = data->diff_size;
+    float x0 = data->frame_px, w = (float)WIDTH - data->frame_px * 2, h = (float)HEIGHT - data->frame_px * 2;
+    float split = x0 + h * (float)DIFF_PANEL, top = data->diff_top > 0.0f ? data->diff_top : 1.0f, lo, hi;
+    struct diffmeshjob_s job;
+
+    k = data->diff_ratio ? 1 : 0;
+    lo = (float)fabs(data->diff_lo[k] - (float)k);
+    hi = (float)fabs(data->diff_hi[k] - (float)k);
+    job.series[0] = flat_samples(data);
+    job.series[1] = data->other;
+    job.series[2] = data->diff_ratio ? data->ratio : data->delta;
+    job.base[0] = job.base[1] = split;
+    job.center[0] = job.center[1] = 0.0f;
+    job.scale[0] = job.scale[1] = (h - (split - x0)) / top;
+    job.center[2] = (float)k;
+    job.base[2] = x0 + (split - x0) * 0.5f;
+    job.scale[2] = (split - x0) * 0.45f / (hi > lo ? hi : lo > 0.0f ? lo : 1.0f);
+    job.size = n;
+    job.num_segments = (size_t)pool_width() < n ? (size_t)pool_width() : n;
+    job.x0 = x0;
+    job.w = w;
+    job.mesh = arena_alloc(data->arena, sizeof(vec2_t) * (n * 3 + 2));
+    pool_parallel_for(job.num_segments, &diff_mesh_segment, &job);
+    job.mesh[n * 3][0] = x0;
+    job.mesh[n * 3 + 1][0] = x0 + w;
+    job.mesh[n * 3][1] = job.mesh[n * 3 + 1][1] = job.base[2];
+
+    glNamedBufferData(glvbo, sizeof(vec2_t) * (n * 3 + 2), job.mesh, GL_STATIC_DRAW);
+    add_strip(GL_LINES, n * 3, 2, AXIS_COLOR);
+    add_strip(GL_LINE_STRIP, n * 2, n, DELTA_COLOR);
+    add_strip(GL_LINE_STRIP, 0, n, SERIES_COLOR);
+    add_strip(GL_LINE_STRIP, n, n, DIFF_B_COLOR);
+    arena_free(data->arena, job.mesh);
+
+    /* the gridlines stay out of the delta panel */
+    set_axes(0.0, (double)n, -(double)top * (split - x0) / (h - (split - x0)), top, nice_step(top, AXIS_TICKS));
+    glaxes.y_first = 0.0;
+}
+
+static void upload_graph(const struct graphdata_s *data)
+{
+    glnumstrips = 0;
+    if(data->delta)
+        upload_diff(data);
+    else if(data->histogram)
+        upload_histogram(data);
+    else if(data->spectrum)
+        upload_spectrum(data);
+    else if(data->columns)
+        upload_envelope(data);
+    else
+        upload_series(data);
+    upload_axes(data);
+}
+
+static void set_program_color(GLuint program, unsigned color)
+{
+    glProgramUniform3f(program, 0, (float)((color >> 16) & 0xFF) / 255.0f,
+        (float)((color >> 8) & 0xFF) / 255.0f, (float)(color & 0xFF) / 255.0f);
+}
+
+static void set_color(unsigned color)
+{
+    set_program_color(glprogram, color);
+}
+
+static void draw_graph(const struct graphdata_s *data)
+{
+    int k;
+
+    /* clear */
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    /* grid and labels under the graph, in one instanced draw */
+    if(glnumquads) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBindVertexArray(glquadvao);
+        glUseProgram(glquadprogram);
+        glBindTextureUnit(0, glfont);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, glnumquads);
+        glDisable(GL_BLEND);
+    }
+
+    /* the follow view's columns, blended over the grid */
+    if(glscrolltex) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBindVertexArray(glvao);
+        glUseProgram(glscrollprogram);
+        glBindTextureUnit(0, glscrolltex);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glDisable(GL_BLEND);
+    }
+
+    /* draw; what --animate pans past the frame is cut off there */
+    if(glpanning) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor((GLint)data->frame_px, 0, (GLsizei)((float)WIDTH - data->frame_px * 2), HEIGHT);
+    }
+    glLineWidth(data->line_width);
+    glBindVertexArray(glvao);
+    glUseProgram(glprogram);
+    for(k = 0; k < glnumstrips; k++) {
+        set_color(glstrips[k].color);
+        glDrawArrays(glstrips[k].mode, glstrips[k].first, glstrips[k].count);
+    }
+    if(glpanning)
+        glDisable(GL_SCISSOR_TEST);
+}
+
+/* --animate: samples [first, first + count) across the frame, the
+ * vertices as the series view laid them out */
+static void set_view(const struct graphdata_s *data, size_t first, size_t count)
+{
+    float w = (float)WIDTH - data->frame_px * 2, scale = (float)data->size / (float)count;
+
+    glProgramUniform2f(glprogram, 1, scale, data->frame_px - data->frame_px * scale - (float)first * w / (float)count);
+    glpanning = 1;
+    set_axes((double)first, (double)(first + count), 0.0, data->max_value, data->tick_size);
+    upload_axes(data);
+}
+
+static char *read_pixels(struct arena_s *arena)
+{
+    char *pixels = arena_alloc(arena, 3 * WIDTH * HEIGHT);
+    glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    return pixels;
+}
+
+static uint32_t png_crc(uint32_t crc, const unsigned char *bytes, size_t size)
+{
+#if UNDGRAPH_HAVE_ZLIB
+    return (uint32_t)crc32(crc, bytes, (uInt)size);
+#else
+    static const uint32_t nibbles[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    crc = ~crc;
+    while(size--) {
+        crc ^= *bytes++;
+        crc = (crc >> 4) ^ nibbles[crc & 15];
+        crc = (crc >> 4) ^ nibbles[crc & 15];
+    }
+    return ~crc;
+#endif
+}
+
+static void put_be32(unsigned char *p, uint32_t value)
+{
+    p[0] = (unsigned char)(value >> 24);
+    p[1] = (unsigned char)(value >> 16);
+    p[2] = (unsigned char)(value >> 8);
+    p[3] = (unsigned char)value;
+}
+
+static void png_chunk(struct pngwriter_s *png, const char *type, const unsigned char *data, size_t size)
+{
+    unsigned char head[8], tail[4];
+
+    put_be32(head, (uint32_t)size);
+    memcpy(head + 4, type, 4);
+    put_be32(tail, size ? png_crc(png_crc(0, head + 4, 4), data, size) : png_crc(0, head + 4, 4));
+    if(!png->failed)
+        png->failed = !png->write(png->ctx, head, 8) || (size && !png->write(png->ctx, data, size)) || !png->write(png->ctx, tail, 4);
+}
+
+static void png_flush(struct pngwriter_s *png)
+{
+    if(png->out_used)
+        png_chunk(png, "IDAT", png->out, png->out_used);
+    png->out_used = 0;
+}
+
+#if !UNDGRAPH_HAVE_ZLIB
+/* without zlib the rows go out as stored deflate blocks */
+static void png_put(struct pngwriter_s *png, const unsigned char *bytes, size_t size)
+{
+    size_t n;
+
+    while(size) {
+        n = PNG_IDAT_SIZE - png->out_used < size ? PNG_IDAT_SIZE - png->out_used : size;
+        memcpy(png->out + png->out_used, bytes, n);
+        png->out_used += n;
+        bytes += n;
+        size -= n;
+        if(png->out_used == PNG_IDAT_SIZE)
+            png_flush(png);
+    }
+}
+
+static void png_stored(struct pngwriter_s *png, const unsigned char *bytes, size_t size, int last)
+{
+    size_t i, n;
+    unsigned char head[5];
+
+    for(i = 0; i < size; i += 5552) {
+        for(n = i; n < size && n < i + 5552; n++) {
+            png->adler_a += bytes[n];
+            png->adler_b += png->adler_a;
+        }
+        png->adler_a %= 65521;
+        png->adler_b %= 65521;
+    }
+
+    for(; size; bytes += n, size -= n) {
+        n = size < 65535 ? size : 65535;
+        head[0] = (unsigned char)(last && n == size);
+        head[1] = (unsigned char)n;
+        head[2] = (unsigned char)(n >> 8);
+        head[3] = (unsigned char)~n;
+        head[4] = (unsigned char)(~n >> 8);
+        png_put(png, head, 5);
+        png_put(png, bytes, n);
+    }
+}
+#endif
+
+/* feeds one filtered row to the compressor, or finishes the stream */
+static void png_deflate(struct pngwriter_s *png, const unsigned char *bytes, size_t size, int last)
+{
+#if UNDGRAPH_HAVE_ZLIB
+    int zr;
+
+    png->zs.next_in = (Bytef *)bytes;
+    png->zs.avail_in = (uInt)size;
+    do {
+        png->zs.next_out = png->out + png->out_used;
+        png->zs.avail_out = (uInt)(PNG_IDAT_SIZE - png->out_used);
+        zr = deflate(&png->zs, last ? Z_FINISH : Z_NO_FLUSH);
+        png->out_used = PNG_IDAT_SIZE - png->zs.avail_out;
+        if(png->out_used == PNG_IDAT_SIZE)
+            png_flush(png);
+        if(zr == Z_STREAM_ERROR)
+            png->failed = 1;
+    } while(!png->failed && (png->zs.avail_in || (last && zr != Z_STREAM_END)));
+#else
+    unsigned char adler[4];
+
+    png_stored(png, bytes, size, last);
+    if(last) {
+        put_be32(adler, (png->adler_b << 16) | png->adler_a);
+        png_put(png, adler, 4);
+    }
+#endif
+}
+
+/* the five png filters of a row against the one above */
+static void png_filter(const unsigned char *row, const unsigned char *prev, size_t size, int bpp, int filter, unsigned char *out)
+{
+    size_t i;
+    int a, b, c, p, pa, pb, pc;
+
+    out[0] = (unsigned char)filter;
+    for(i = 0; i < size; i++) {
+        a = i >= (size_t)bpp ? row[i - bpp] : 0;
+        b = prev[i];
+        c = i >= (size_t)bpp ? prev[i - bpp] : 0;
+        switch(filter) {
+        case 0:
+            p = 0;
+            break;
+        case 1:
+            p = a;
+            break;
+        case 2:
+            p = b;
+            break;
+        case 3:
+            p = (a + b) >> 1;
+            break;
+        default:
+            pa = abs(b - c);
+            pb = abs(a - c);
+            pc = abs(a + b - c * 2);
+            p = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+            break;
+        }
+        out[i + 1] = (unsigned char)(row[i] - p);
+    }
+}
+
+static int png_begin(struct pngwriter_s *png, int width, int height, int channels,
+    int (*write)(void *ctx, const void *bytes, size_t size), void *ctx, struct arena_s *arena)
+{
+    unsigned char ihdr[13];
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    static const unsigned char color_types[5] = { 0, 0, 4, 2, 6 };
+
+    memset(png, 0, sizeof(struct pngwriter_s));
+    png->write = write;
+    png->ctx = ctx;
+    png->channels = channels;
+    png->row_bytes = (size_t)width * (size_t)channels;
+    png->rows_left = height;
+    png->prev = arena_alloc(arena, png->row_bytes * 3 + 2 + PNG_IDAT_SIZE);
+    png->best = png->prev + png->row_bytes;
+    png->trial = png->best + png->row_bytes + 1;
+    png->out = png->trial + png->row_bytes + 1;
+    memset(png->prev, 0, png->row_bytes);
+
+#if UNDGRAPH_HAVE_ZLIB
+    png->zs.zalloc = &zlib_alloc;
+    png->zs.zfree = &zlib_free;
+    png->zs.opaque = arena;
+    if(deflateInit(&png->zs, PNG_LEVEL) != Z_OK)
+        return 0;
+#else
+    png->adler_a = 1;
+    png->adler_b = 0;
+    png->out[0] = 0x78;
+    png->out[1] = 0x01;
+    png->out_used = 2;
+#endif
+
+    put_be32(ihdr, (uint32_t)width);
+    put_be32(ihdr + 4, (uint32_t)height);
+    ihdr[8] = 8;
+    ihdr[9] = color_types[channels];
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    png->failed = !write(ctx, signature, sizeof(signature));
+    png_chunk(png, "IHDR", ihdr, sizeof(ihdr));
+    return !png->failed;
+}
+
+/* count rows, stride bytes apart; a negative stride walks an image that
+ * is stored bottom-up, the way glReadPixels leaves it */
+static void png_rows(struct pngwriter_s *png, const unsigned char *rows, int count, ptrdiff_t stride)
+{
+    int k, filter;
+    size_t i, cost, best_cost;
+    unsigned char *swap;
+
+    for(; count > 0 && png->rows_left > 0 && !png->failed; count--, rows += stride) {
+        /* the filter with the smallest sum of signed residuals */
+        for(best_cost = (size_t)-1, filter = 0; filter < 5; filter++) {
+            png_filter(rows, png->prev, png->row_bytes, png->channels, filter, png->trial);
+            for(cost = 0, i = 1; i <= png->row_bytes; i++)
+                cost += (size_t)abs((signed char)png->trial[i]);
+            if(cost < best_cost) {
+                best_cost = cost;
+                swap = png->best;
+                png->best = png->trial;
+                png->trial = swap;
+            }
+        }
+        memcpy(png->prev, rows, png->row_bytes);
+
+        k = --png->rows_left == 0;
+        png_deflate(png, png->best, png->row_bytes + 1, k);
+    }
+}
+
+/* the rest of the data and IEND; 1 if every byte went out */
+static int png_end(struct pngwriter_s *png)
+{
+    if(png->rows_left && !png->failed) {
+        lprintf("png: %d row(s) missing\n", png->rows_left);
+        png->failed = 1;
+    }
+    png_flush(png);
+    png_chunk(png, "IEND", NULL, 0);
+#if UNDGRAPH_HAVE_ZLIB
+    deflateEnd(&png->zs);
+#endif
+    return !png->failed;
+}
+
+static int png_fwrite(void *ctx, const void *bytes, size_t size)
+{
+    return fwrite(bytes, size, 1, ctx) == 1;
+}
+
+/* needs no GL context, so it can run on any thread. with zlib the rows
+ * stream out, otherwise stb compresses the whole image at once */
+static int write_png(const char *filename, const char *pixels, struct arena_s *arena)
+{
+    int ok;
+#if UNDGRAPH_HAVE_ZLIB
+    FILE *fp;
+    struct pngwriter_s png;
+
+    fp = fopen(filename, "wb");
+    if(!fp)
+        return 0;
+    ok = png_begin(&png, WIDTH, HEIGHT, 3, &png_fwrite, fp, arena);
+    if(ok) {
+        png_rows(&png, (const unsigned char *)pixels + (size_t)(HEIGHT - 1) * WIDTH * 3, HEIGHT, -(ptrdiff_t)WIDTH * 3);
+        ok = png_end(&png);
+    }
+    ok = !fclose(fp) && ok;
+#else
+    stbiw_arena = arena;
+    ok = stbi_write_png(filename, WIDTH, HEIGHT, 3, pixels, 3 * WIDTH);
+    stbiw_arena = NULL;
+#endif
+    return ok;
+}
+
+static int save_png(const char *filename, struct arena_s *arena)
+{
+    int ok;
+    char *pixels;
+
+    pixels = read_pixels(arena);
+    ok = write_png(filename, pixels, arena);
+    arena_free(arena, pixels);
+    return ok;
+}
+
+struct digestjob_s {
+    const float *values;
+    size_t size;
+    size_t num_segments;
+    struct tdigest_s *digests;
+};
+
+static void digest_segment(void *arg, size_t segment)
+{
+    struct digestjob_s *job = arg;
+    size_t i;
+
+    tdigest_init(job->digests + segment);
+    for(i = segment * job->size / job->num_segments; i < (segment + 1) * job->size / job->num_segments; i++)
+        tdigest_add(job->digests + segment, job->values[i], 1.0);
+}
+
+/* sketches the segments side by side and merges them into digest */
+static void digest_values(const float *values, size_t size, struct arena_s *arena, struct tdigest_s *digest)
+{
+    size_t s;
+    struct digestjob_s job;
+
+    tdigest_init(digest);
+    if(!size)
+        return;
+
+    job.values = values;
+    job.size = size;
+    job.num_segments = (size_t)pool_width() < size ? (size_t)pool_width() : size;
+    job.digests = arena_alloc(arena, sizeof(struct tdigest_s) * job.num_segments);
+    pool_parallel_for(job.num_segments, &digest_segment, &job);
+    for(s = 0; s < job.num_segments; s++)
+        tdigest_merge(digest, job.digests + s);
+    arena_free(arena, job.digests);
+}
+
+static void build_digest(const struct graphdata_s *data, struct tdigest_s *digest)
+{
+    const float *values = data->size ? flat_samples(data) : NULL;
+
+    digest_values(values, data->size, data->arena, digest);
+    release_flat(data, values);
+}
+
+/* per worker sums of a and b over the pairs with a finite delta, and
+ * the finite range of the delta and of the ratio */
+struct diffsum_s {
+    double sum_a;
+    double sum_b;
+    size_t count;
+    float lo[2];
+    float hi[2];
+};
+
+struct diffjob_s {
+    const float *a;
+    const float *b;
+    float *delta;
+    float *ratio;
+    size_t size;
+    struct diffsum_s *sums;
+};
+
+/* the delta and the ratio of one stretch of pairs; the sums and ranges
+ * only take pairs whose delta (or ratio) is finite, so a nan on either
+ * side or a zero under the ratio leaves them alone */
+static void diff_values(const float *a, const float *b, float *delta, float *ratio, size_t count, struct diffsum_s *sum)
+{
+    size_t i = 0;
+    float d, r;
+    double sum_a = 0.0, sum_b = 0.0;
+#if UNDGRAPH_SSE2
+    float lanes[4];
+    uint32_t counts[4];
+    __m128 va, vb, vd, vr, dok, rok;
+    __m128 big = _mm_set1_ps(FLT_MAX), small = _mm_set1_ps(-FLT_MAX);
+    __m128 magnitude = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 sa = _mm_setzero_ps(), sb = _mm_setzero_ps();
+    __m128 dlo = big, dhi = small, rlo = big, rhi = small;
+    __m128i n = _mm_setzero_si128();
+
+    for(; i + 4 <= count; i += 4) {
+        va = _mm_loadu_ps(a + i);
+        vb = _mm_loadu_ps(b + i);
+        vd = _mm_sub_ps(vb, va);
+        vr = _mm_div_ps(vb, va);
+        _mm_storeu_ps(delta + i, vd);
+        _mm_storeu_ps(ratio + i, vr);
+
+        /* false for nan and for both infinities */
+        dok = _mm_cmple_ps(_mm_and_ps(vd, magnitude), big);
+        rok = _mm_cmple_ps(_mm_and_ps(vr, magnitude), big);
+        sa = _mm_add_ps(sa, _mm_and_ps(dok, va));
+        sb = _mm_add_ps(sb, _mm_and_ps(dok, vb));
+        n = _mm_sub_epi32(n, _mm_castps_si128(dok));
+        dlo = _mm_min_ps(dlo, _mm_or_ps(_mm_and_ps(dok, vd), _mm_andnot_ps(dok, big)));
+        dhi = _mm_max_ps(dhi, _mm_or_ps(_mm_and_ps(dok, vd), _mm_andnot_ps(dok, small)));
+        rlo = _mm_min_ps(rlo, _mm_or_ps(_mm_and_ps(rok, vr), _mm_andnot_ps(rok, big)));
+        rhi = _mm_max_ps(rhi, _mm_or_ps(_mm_and_ps(rok, vr), _mm_andnot_ps(rok, small)));
+    }
+
+    _mm_storeu_ps(lanes, sa);
+    sum_a = (double)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_ps(lanes, sb);
+    sum_b = (double)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_si128((__m128i *)counts, n);
+    sum->count += (size_t)counts[0] + counts[1] + counts[2] + counts[3];
+    dlo = _mm_min_ps(dlo, _mm_shuffle_ps(dlo, dlo, _MM_SHUFFLE(1, 0, 3, 2)));
+    dlo = _mm_min_ps(dlo, _mm_shuffle_ps(dlo, dlo, _MM_SHUFFLE(2, 3, 0, 1)));
+    dhi = _mm_max_ps(dhi, _mm_shuffle_ps(dhi, dhi, _MM_SHUFFLE(1, 0, 3, 2)));
+    dhi = _mm_max_ps(dhi, _mm_shuffle_ps(dhi, dhi, _MM_SHUFFLE(2, 3, 0, 1)));
+    rlo = _mm_min_ps(rlo, _mm_shuffle_ps(rlo, rlo, _MM_SHUFFLE(1, 0, 3, 2)));
+    rlo = _mm_min_ps(rlo, _mm_shuffle_ps(rlo, rlo, _MM_SHUFFLE(2, 3, 0, 1)));
+    rhi = _mm_max_ps(rhi, _mm_shuffle_ps(rhi, rhi, _MM_SHUFFLE(1, 0, 3, 2)));
+    rhi = _mm_max_ps(rhi, _mm_shuffle_ps(rhi, rhi, _MM_SHUFFLE(2, 3, 0, 1)));
+    d = _mm_cvtss_f32(dlo);
+    sum->lo[0] = d < sum->lo[0] ? d : sum->lo[0];
+    d = _mm_cvtss_f32(dhi);
+    sum->hi[0] = d > sum->hi[0] ? d : sum->hi[0];
+    r = _mm_cvtss_f32(rlo);
+    sum->lo[1] = r < sum->lo[1] ? r : sum->lo[1];
+    r = _mm_cvtss_f32(rhi);
+    sum->hi[1] = r > sum->hi[1] ? r : sum->hi[1];
+#endif
+
+    for(; i < count; i++) {
+        d = delta[i] = b[i] - a[i];
+        r = ratio[i] = b[i] / a[i];
+        if(fabs(d) <= FLT_MAX) {
+            sum_a += a[i];
+            sum_b += b[i];
+            sum->count++;
+            sum->lo[0] = d < sum->lo[0] ? d : sum->lo[0];
+            sum->hi[0] = d > sum->hi[0] ? d : sum->hi[0];
+        }
+        if(fabs(r) <= FLT_MAX) {
+            sum->lo[1] = r < sum->lo[1] ? r : sum->lo[1];
+            sum->hi[1] = r > sum->hi[1] ? r : sum->hi[1];
+        }
+    }
+
+    sum->sum_a += sum_a;
+    sum->sum_b += sum_b;
+}
+
+static void diff_blocks(void *arg, size_t first, size_t last)
+{
+    struct diffjob_s *job = arg;
+    size_t block, begin, count;
+
+    for(block = first; block < last; block++) {
+        begin = block * SAMPLES_PER_BLOCK;
+        count = job->size - begin < SAMPLES_PER_BLOCK ? job->size - begin : SAMPLES_PER_BLOCK;
+        diff_values(job->a + begin, job->b + begin, job->delta + begin, job->ratio + begin, count, job->sums + worker_index);
+    }
+}
+
+/* the values of the pairs with a finite delta, the same pairs the means
+ * are taken over */
+static size_t finite_pairs(const float *values, const float *delta, size_t count, float *out)
+{
+    size_t i, kept = 0;
+    for(i = 0; i < count; i++)
+        if(fabs(delta[i]) <= FLT_MAX)
+            out[kept++] = values[i];
+    return kept;
+}
+
+static void print_diff_row(const char *label, double mean, double p50, double p99)
+{
+    printf("%-6s %14.6g %14.6g %14.6g\n", label, mean, p50, p99);
+}
+
+/* --diff: b against a, sample by sample over the samples both have;
+ * prints mean, p50 and p99 of a, b and the delta, and b over a of each,
+ * all over the pairs whose delta is finite */
+static void compute_diff(struct graphdata_s *data, const struct graphdata_s *other)
+{
+    int k;
+    size_t n = data->size < other->size ? data->size : other->size;
+    double start = now_seconds(), mean_a, mean_b, q[3][2];
+    struct diffjob_s job;
+    struct diffsum_s total;
+    struct nodejob_s nodes;
+    struct tdigest_s *digest;
+    float *pairs;
+
+    if(data->size != other->size)
+        lprintf("diff: %zu and %zu samples, comparing the first %zu\n", data->size, other->size, n);
+
+    job.a = flat_samples(data);
+    job.b = flat_samples(other);
+    job.size = n;
+    job.delta = arena_alloc(data->arena, sizeof(float) * n);
+    job.ratio = arena_alloc(data->arena, sizeof(float) * n);
+    job.sums = arena_alloc(data->arena, sizeof(struct diffsum_s) * (size_t)pool_width());
+    memset(&total, 0, sizeof(total));
+    total.lo[0] = total.lo[1] = FLT_MAX;
+    total.hi[0] = total.hi[1] = -FLT_MAX;
+    for(k = 0; k < pool_width(); k++)
+        job.sums[k] = total;
+
+    pool_for_nodes(&nodes, (n + SAMPLES_PER_BLOCK - 1) / SAMPLES_PER_BLOCK, sizeof(float) * SAMPLES_PER_BLOCK * 4, &diff_blocks, &job);
+
+    for(k = 0; k < pool_width(); k++) {
+        total.sum_a += job.sums[k].sum_a;
+        total.sum_b += job.sums[k].sum_b;
+        total.count += job.sums[k].count;
+        total.lo[0] = job.sums[k].lo[0] < total.lo[0] ? job.sums[k].lo[0] : total.lo[0];
+        total.hi[0] = job.sums[k].hi[0] > total.hi[0] ? job.sums[k].hi[0] : total.hi[0];
+        total.lo[1] = job.sums[k].lo[1] < total.lo[1] ? job.sums[k].lo[1] : total.lo[1];
+        total.hi[1] = job.sums[k].hi[1] > total.hi[1] ? job.sums[k].hi[1] : total.hi[1];
+    }
+
+    data->other = job.b;
+    data->delta = job.delta;
+    data->ratio = job.ratio;
+    data->diff_size = n;
+    data->diff_top = data->max_value > other->max_value ? data->max_value : other->max_value;
+    for(k = 0; k < 2; k++) {
+        data->diff_lo[k] = total.lo[k] <= total.hi[k] ? total.lo[k] : 0.0f;
+        data->diff_hi[k] = total.lo[k] <= total.hi[k] ? total.hi[k] : 0.0f;
+    }
+
+    digest = arena_alloc(data->arena, sizeof(struct tdigest_s));
+    pairs = arena_alloc(data->arena, sizeof(float) * n);
+    digest_values(pairs, finite_pairs(job.a, job.delta, n, pairs), data->arena, digest);
+    q[0][0] = tdigest_quantile(digest, 0.5);
+    q[0][1] = tdigest_quantile(digest, 0.99);
+    digest_values(pairs, finite_pairs(job.b, job.delta, n, pairs), data->arena, digest);
+    q[1][0] = tdigest_quantile(digest, 0.5);
+    q[1][1] = tdigest_quantile(digest, 0.99);
+    digest_values(pairs, finite_pairs(job.delta, job.delta, n, pairs), data->arena, digest);
+    q[2][0] = tdigest_quantile(digest, 0.5);
+    q[2][1] = tdigest_quantile(digest, 0.99);
+    arena_shrink(data->arena, pairs, sizeof(float) * n, 0);
+
+    mean_a = total.count ? total.sum_a / (double)total.count : 0.0;
+    mean_b = total.count ? total.sum_b / (double)total.count : 0.0;
+    printf("%-6s %14s %14s %14s\n", "", "mean", "p50", "p99");
+    print_diff_row("a", mean_a, q[0][0], q[0][1]);
+    print_diff_row("b", mean_b, q[1][0], q[1][1]);
+    print_diff_row("b-a", mean_b - mean_a, q[2][0], q[2][1]);
+    print_diff_row("b/a", mean_b / mean_a, q[1][0] / q[0][0], q[1][1] / q[0][1]);
+    arena_free(data->arena, digest);
+
+    lprintf("diff: %zu pairs, %zu finite, in %.1f ms\n", n, total.count, (now_seconds() - start) * 1000.0);
+}
+
+/* the coarsest tier never wraps: once full, pairs of buckets merge and
+ * it goes on at twice the samples per bucket */
+static void fold_tier(struct tier_s *tier)
+{
+    size_t i, half = tier->capacity / 2;
+    float a, b;
+
+    for(i = 0; i < half; i++) {
+        a = tier->lo[i * 2];
+        b = tier->lo[i * 2 + 1];
+        tier->lo[i] = isnan(a) || b < a ? b : a;
+        a = tier->hi[i * 2];
+        b = tier->hi[i * 2 + 1];
+        tier->hi[i] = isnan(a) || b > a ? b : a;
+        a = tier->mean[i * 2];
+        b = tier->mean[i * 2 + 1];
+        tier->mean[i] = isnan(a) ? b : isnan(b) ? a : (a + b) * 0.5f;
+    }
+    tier->count = half;
+    tier->factor *= 2;
+    tier->fill *= 2;
+}
+
+/* takes a sample, or a finished bucket of the tier below, into the open
+ * bucket of tier t; full buckets go on up */
+static void tier_push(struct tier_s *tiers, int t, float lo, float hi, float mean)
+{
+    struct tier_s *tier = tiers + t;
+    size_t slot;
+
+    if(!tier->n) {
+        tier->acc_lo = FLT_MAX;
+        tier->acc_hi = -FLT_MAX;
+        tier->acc_sum = 0.0;
+        tier->finite = 0;
+    }
+    if(!isnan(mean)) {
+        tier->acc_lo = lo < tier->acc_lo ? lo : tier->acc_lo;
+        tier->acc_hi = hi > tier->acc_hi ? hi : tier->acc_hi;
+        tier->acc_sum += mean;
+        tier->finite++;
+    }
+    if(++tier->n < tier->fill)
+        return;
+
+    if(tier->finite) {
+        lo = tier->acc_lo;
+        hi = tier->acc_hi;
+        mean = (float)(tier->acc_sum / (double)tier->finite);
+    }
+    else
+        lo = hi = mean; /* nothing but nans, this one too */
+    slot = tier->count++ % tier->capacity;
+    tier->lo[slot] = lo;
+    tier->hi[slot] = hi;
+    tier->mean[slot] = mean;
+    tier->n = 0;
+
+    if(t + 1 < HISTORY_TIERS)
+        tier_push(tiers, t + 1, lo, hi, mean);
+    else if(tier->count == tier->capacity)
+        fold_tier(tier);
+}
+
+/* the samples [first, last) a tier still has, whole buckets only */
+static void tier_span(const struct tier_s *tier, int coarsest, size_t *first, size_t *last)
+{
+    size_t kept = coarsest || tier->count < tier->capacity ? tier->count : tier->capacity;
+    *first = (tier->count - kept) * tier->factor;
+    *last = tier->count * tier->factor;
+}
+
+/* low, high and mean of the samples [a, b), each part from the finest
+ * level that still has it: the raw window, then the tiers in turn.
+ * returns how many samples or buckets had a finite value */
+static size_t history_range(const struct follow_s *f, size_t a, size_t b, float *lo, float *hi, double *sum)
+{
+    int t;
+    size_t i, end = b, first, last, n = 0, slot;
+    const struct tier_s *tier;
+
+    *lo = FLT_MAX;
+    *hi = -FLT_MAX;
+    *sum = 0.0;
+
+    first = f->count - (f->count - f->raw_first < FOLLOW_WINDOW ? f->count - f->raw_first : FOLLOW_WINDOW);
+    for(i = a > first ? a : first; i < end; i++) {
+        slot = i & (FOLLOW_WINDOW - 1);
+        if(isnan(f->ring[slot]))
+            continue;
+        *lo = f->ring[slot] < *lo ? f->ring[slot] : *lo;
+        *hi = f->ring[slot] > *hi ? f->ring[slot] : *hi;
+        *sum += f->ring[slot];
+        n++;
+    }
+    first = a > first ? a : first;
+    end = first < end ? first : end;
+
+    for(t = 0; t < HISTORY_TIERS && a < end; t++) {
+        tier = f->tiers + t;
+        tier_span(tier, t == HISTORY_TIERS - 1, &first, &last);
+        first = a > first ? a : first;
+        last = end < last ? end : last;
+        for(i = first / tier->factor; i * tier->factor < last; i++) {
+            slot = i % tier->capacity;
+            if(isnan(tier->mean[slot]))
+                continue;
+            *lo = tier->lo[slot] < *lo ? tier->lo[slot] : *lo;
+            *hi = tier->hi[slot] > *hi ? tier->hi[slot] : *hi;
+            *sum += tier->mean[slot];
+            n++;
+        }
+        end = first < end ? first : end;
+    }
+    return n;
+}
+
+/* history:N: the whole run so far, a column per pixel, as the band from
+ * low to high with the mean on top; scaled to the largest sample seen */
+static void upload_history(struct follow_s *f, const struct graphdata_s *data)
+{
+    int k;
+    size_t c, a, b, n, columns = (size_t)f->columns;
+    float x0 = (float)f->x0, h = (float)HEIGHT - data->frame_px * 2, y, lo, hi, mean = 0.0f, top, step;
+    double sum;
+    vec2_t *mesh = f->mesh;
+
+    top = f->digest->max > 0.0 ? (float)f->digest->max : 1.0f;
+    step = (float)nice_step(top, AXIS_TICKS);
+    top = (float)ceil(top / step) * step;
+
+    /* columns with nothing finite carry the one before over */
+    lo = hi = 0.0f;
+    for(c = 0; c < columns; c++) {
+        a = (size_t)((double)c * (double)f->count / (double)columns);
+        b = (size_t)((double)(c + 1) * (double)f->count / (double)columns);
+        b = b > a ? b : a + 1;
+        n = history_range(f, a, b, &lo, &hi, &sum);
+        if(n)
+            mean = (float)(sum / (double)n);
+        else if(c) {
+            lo = (mesh[c * 2 - 2][1] - data->frame_px) / h * top;
+            hi = (mesh[c * 2 - 1][1] - data->frame_px) / h * top;
+        }
+        else
+            lo = hi = 0.0f;
+        mesh[c * 2][0] = mesh[c * 2 + 1][0] = mesh[columns * 2 + c][0] = x0 + (float)c + 0.5f;
+        mesh[c * 2][1] = data->frame_px + lo / top * h;
+        mesh[c * 2 + 1][1] = data->frame_px + hi / top * h;
+        mesh[columns * 2 + c][1] = data->frame_px + mean / top * h;
+    }
+    for(k = 0, c = columns * 3; k < NUM_REFLINES; k++, c += 2) {
+        y = (float)f->refs[k] / top;
+        y = data->frame_px + (y < 1.0f ? y : 1.0f) * h;
+        mesh[c][0] = x0;
+        mesh[c + 1][0] = x0 + (float)columns;
+        mesh[c][1] = mesh[c + 1][1] = y;
+    }
+
+    glNamedBufferSubData(glvbo, 0, sizeof(vec2_t) * (columns * 3 + NUM_REFLINES * 2), mesh);
+    glnumstrips = 0;
+    add_strip(GL_TRIANGLE_STRIP, 0, columns * 2, ENVELOPE_COLOR);
+    add_strip(GL_LINE_STRIP, columns * 2, columns, SERIES_COLOR);
+    for(k = 0; k < NUM_REFLINES; k++)
+        add_strip(GL_LINE_STRIP, columns * 3 + (size_t)k * 2, 2, refline_colors[k]);
+
+    set_axes(0.0, (double)f->count, 0.0, top, 0.0);
+    upload_axes(data);
+}
+
+/* the overlays advance with each sample, in the order compute_overlays
+ * lays them out */
+static void follow_push(struct follow_s *f, const struct graphdata_s *data, float x)
+{
+    int k = 0;
+    float lo;
+    size_t slot = f->count++ & (FOLLOW_WINDOW - 1);
+
+    f->ring[slot] = x;
+    rollminmax_push(&f->range, x, &lo, &f->window_max);
+    if(f->tiers[0].capacity)
+        tier_push(f->tiers, 0, x, x, x);
+    if(data->ma_window)
+        f->rings[k++][slot] = rollmean_push(&f->ma, x);
+    if(data->ewma_alpha > 0.0f)
+        f->rings[k++][slot] = ewma_push(&f->ewma, x);
+    if(data->minmax_window) {
+        rollminmax_push(&f->minmax, x, f->rings[k] + slot, f->rings[k + 1] + slot);
+        k += 2;
+    }
+    if(data->pct_window) {
+        rollpct_push(&f->pct, x);
+        f->rings[k][slot] = rollpct_get(&f->pct, 0.5);
+        f->rings[k + 1][slot] = rollpct_get(&f->pct, 0.99);
+    }
+}
+
+static void update_references(struct follow_s *f)
+{
+    f->refs[0] = tdigest_quantile(f->digest, 0.5);
+    f->refs[1] = tdigest_quantile(f->digest, 0.99);
+    f->refs[2] = tdigest_quantile(f->digest, 0.999);
+    f->refs[3] = f->digest->max;
+}
+
+static void stop_follow(struct follow_s *f)
+{
+    if(f->fp)
+        fclose(f->fp);
+    if(f->journal)
+        fclose(f->journal);
+    if(f->replay)
+        fclose(f->replay);
+    if(f->alert_list.runs)
+        mutex_destroy(&f->alert_list.lock);
+    f->fp = f->journal = f->replay = NULL;
+    f->alert_list.runs = NULL;
+}
+
+/* --follow: keeps reading what gets appended to a text file. the loaded
+ * samples seed the sketch and the last window of them the live view */
+static int start_follow(struct follow_s *f, struct graphdata_s *data, const char *filename)
+{
+    int k;
+    size_t i, first, warm;
+    char magic[8] = { 0 };
+    struct stat st;
+    const float *values;
+    struct tier_s *tier;
+    struct arena_s *arena = data->arena;
+
+    memset(f, 0, sizeof(struct follow_s));
+    f->filename = filename;
+    f->fp = fopen(filename, "rb");
+    if(!f->fp || stat(filename, &st)) {
+        lprintf("%s: %s\n", filename, strerror(errno));
+        return 0;
+    }
+
+    if(fread(magic, 1, sizeof(magic), f->fp) != sizeof(magic) || memcmp(magic, "undgraph", 8)) {
+        lprintf("%s: --follow needs a plain text undgraph file\n", filename);
+        goto error;
+    }
+    if(data->histogram || data->spectrum || data->columns) {
+        lprintf("%s: --follow only updates the series view\n", filename);
+        goto error;
+    }
+
+    fseek(f->fp, 0, SEEK_END);
+    f->offset = (uint64_t)st.st_size;
+    f->buffer = arena_alloc(arena, FOLLOW_CHUNK + 1);
+    f->batch = arena_alloc(arena, sizeof(float) * (FOLLOW_CHUNK / 2 + 1));
+    f->payload = arena_alloc(arena, max_encoded_size(SAMPLES_PER_BLOCK));
+    f->ring = arena_alloc(arena, sizeof(float) * FOLLOW_WINDOW);
+    f->mesh = arena_alloc(arena, sizeof(vec2_t) * (FOLLOW_WINDOW + 1) * (size_t)(data->num_overlays + 1));
+    f->num_overlays = data->num_overlays;
+    for(k = 0; k < data->num_overlays; k++)
+        f->rings[k] = arena_alloc(arena, sizeof(float) * FOLLOW_WINDOW);
+
+    warm = FOLLOW_WINDOW;
+    rollminmax_init(&f->range, FOLLOW_WINDOW, arena_alloc(arena, rollminmax_bytes(FOLLOW_WINDOW)));
+    if(data->ma_window) {
+        rollmean_init(&f->ma, data->ma_window, arena_alloc(arena, rollmean_bytes(data->ma_window)));
+        warm = data->ma_window > warm ? data->ma_window : warm;
+    }
+    if(data->ewma_alpha > 0.0f)
+        ewma_init(&f->ewma, data->ewma_alpha);
+    if(data->minmax_window) {
+        rollminmax_init(&f->minmax, data->minmax_window, arena_alloc(arena, rollminmax_bytes(data->minmax_window)));
+        warm = data->minmax_window > warm ? data->minmax_window : warm;
+    }
+    if(data->pct_window) {
+        rollpct_init(&f->pct, data->pct_window, arena_alloc(arena, rollpct_bytes(data->pct_window)));
+        warm = data->pct_window > warm ? data->pct_window : warm;
+    }
+
+    f->digest = arena_alloc(arena, sizeof(struct tdigest_s));
+    build_digest(data, f->digest);
+    update_references(f);
+
+    /* the window states only need the last window; the ewma starts there.
+     * the history takes everything before it directly */
+    values = flat_samples(data);
+    first = data->size > warm ? data->size - warm : 0;
+    if(data->history) {
+        for(k = 0; k < HISTORY_TIERS; k++) {
+            tier = f->tiers + k;
+            tier->capacity = (data->history + 1) & ~(size_t)1;
+            tier->lo = arena_alloc(arena, sizeof(float) * tier->capacity);
+            tier->hi = arena_alloc(arena, sizeof(float) * tier->capacity);
+            tier->mean = arena_alloc(arena, sizeof(float) * tier->capacity);
+            tier->factor = k ? f->tiers[k - 1].factor * HISTORY_FACTOR : HISTORY_FACTOR;
+            tier->fill = HISTORY_FACTOR;
+        }
+        for(i = 0; i < first; i++)
+            tier_push(f->tiers, 0, values[i], values[i], values[i]);
+        lprintf("history: %d tier(s) of %zu bucket(s), %.1f MiB\n", HISTORY_TIERS, f->tiers[0].capacity,
+            (double)(sizeof(float) * 3 * HISTORY_TIERS * f->tiers[0].capacity) / 1048576.0);
+    }
+    f->count = first;
+    f->raw_first = first;
+    for(i = first; i < data->size; i++)
+        follow_push(f, data, values[i]);
+
+    /* the ring only goes back a window */
+    if(data->alerts.rules) {
+        f->alerts = data->alerts;
+        f->alerts.window = f->alerts.window < FOLLOW_WINDOW ? f->alerts.window : FOLLOW_WINDOW;
+        f->alert_history = arena_alloc(arena, sizeof(float) * alert_halo(&f->alerts));
+        f->alert_list.runs = arena_alloc(arena, sizeof(struct alertrun_s) * MAX_REPORTED);
+        f->alert_list.capacity = MAX_REPORTED;
+        mutex_init(&f->alert_list.lock);
+    }
+
+    if(options.record_filename) {
+        f->journal = fopen(options.record_filename, "wb");
+        if(!f->journal) {
+            lprintf("%s: %s\n", options.record_filename, strerror(errno));
+            goto error;
+        }
+        fwrite(JOURNAL_MAGIC, 1, 8, f->journal);
+        write_u32(f->journal, JOURNAL_VERSION);
+        f->journal_start = now_seconds();
+        f->sync_every = options.sync_every;
+    }
+
+    if(options.replay_filename) {
+        f->replay = fopen(options.replay_filename, "rb");
+        if(!f->replay) {
+            lprintf("%s: %s\n", options.replay_filename, strerror(errno));
+            goto error;
+        }
+        if(fread(magic, 1, sizeof(magic), f->replay) != sizeof(magic) || memcmp(magic, JOURNAL_MAGIC, 8) ||
+            read_u32(f->replay) != JOURNAL_VERSION) {
+            lprintf("%s: not an undgraph journal\n", options.replay_filename);
+            goto error;
+        }
+        f->replay_start = now_seconds();
+        f->replay_speed = options.replay_speed;
+    }
+
+    lprintf("follow: %s from byte %llu, %zu sample(s) sketched in %zu centroid(s)\n", filename,
+        (unsigned long long)f->offset, data->size, f->digest->num_centroids);
+    return 1;
+
+error:
+    stop_follow(f);
+    return 0;
+}
+
+/* the alert rules over a batch, with the window before it out of the
+ * ring; a run is printed when it starts, not again as it goes on */
+static void follow_alerts(struct follow_s *f, const float *values, size_t count)
+{
+    size_t i, halo = alert_halo(&f->alerts), seen = f->count - f->raw_first;
+    float lo, hi;
+    struct alertscan_s scan;
+    struct alertrun_s *run;
+
+    halo = seen < halo ? seen : halo;
+    for(i = 0; i < halo; i++)
+        f->alert_history[i] = f->ring[(f->count - halo + i) & (FOLLOW_WINDOW - 1)];
+
+    init_scan(&scan, &f->alerts, &f->alert_list);
+    scan.index = f->count;
+    scan_alerts(&scan, values, count, f->alert_history, halo, &lo, &hi);
+    flush_hits(&scan);
+
+    for(i = 0; i < f->alert_list.count; i++) {
+        run = f->alert_list.runs + i;
+        if(f->alert_last[run->rule] + 1 != run->first || !f->alert_seen[run->rule]) {
+            print_run(stdout, f->filename, &f->alerts, run);
+            if(alert_file) {
+                print_run(alert_file, f->filename, &f->alerts, run);
+                fflush(alert_file);
+            }
+        }
+        f->alert_last[run->rule] = run->last;
+        f->alert_seen[run->rule] = 1;
+    }
+    f->alert_list.count = 0;
+}
+
+/* one batch through the sketch and the window */
+static void follow_ingest(struct follow_s *f, const struct graphdata_s *data, const float *values, size_t count)
+{
+    size_t i;
+
+    if(f->alerts.rules)
+        follow_alerts(f, values, count);
+
+    for(i = 0; i < count; i++) {
+        if(isnan(values[i]))
+            f->nan_count++;
+        tdigest_add(f->digest, values[i], 1.0);
+        follow_push(f, data, values[i]);
+    }
+}
+
+/* --record: appends a batch as journal blocks. the whole batch reaches
+ * the OS before this returns, and the disk every sync_every batches */
+static void record_batch(struct follow_s *f, const float *values, size_t count)
+{
+    size_t i, n, nbytes;
+    uint64_t t = (uint64_t)((now_seconds() - f->journal_start) * 1.0e9);
+
+    for(i = 0; i < count; i += n) {
+        n = count - i < SAMPLES_PER_BLOCK ? count - i : SAMPLES_PER_BLOCK;
+        nbytes = encode_block(values + i, n, CODEC_RAW, f->payload);
+        write_u64(f->journal, t);
+        write_u32(f->journal, (uint32_t)n);
+        write_u32(f->journal, (uint32_t)nbytes);
+        write_u32(f->journal, CODEC_RAW);
+        fwrite(f->payload, 1, nbytes, f->journal);
+    }
+
+    fflush(f->journal);
+    if(f->sync_every && ++f->journal_batches % f->sync_every == 0)
+        sync_file(f->journal);
+    if(ferror(f->journal)) {
+        lprintf("journal: write error, recording stopped\n");
+        fclose(f->journal);
+        f->journal = NULL;
+    }
+}
+
+/* --replay: blocks come back at their recorded pace times speed, or as
+ * fast as they decode with speed 0, through the same ingest */
+static size_t replay_follow(struct follow_s *f, const struct graphdata_s *data)
+{
+    int block;
+    uint32_t codec;
+    size_t added = 0;
+    double elapsed = (now_seconds() - f->replay_start) * f->replay_speed;
+
+    for(block = 0; block < REPLAY_BLOCKS && !f->replay_done; block++) {
+        if(!f->replay_pending) {
+            f->replay_time = read_u64(f->replay);
+            f->replay_count = read_u32(f->replay);
+            f->replay_nbytes = read_u32(f->replay);
+            codec = read_u32(f->replay);
+            f->replay_codec = (int)codec;
+            if(feof(f->replay)) {
+                f->replay_done = 1;
+                break;
+            }
+            if(f->replay_count > SAMPLES_PER_BLOCK || f->replay_nbytes > max_encoded_size(SAMPLES_PER_BLOCK) || codec > CODEC_XOR ||
+               (codec == CODEC_RAW && f->replay_nbytes != sizeof(float) * f->replay_count)) {
+                lprintf("journal: bad block after %zu sample(s)\n", f->replay_samples);
+                f->replay_done = 1;
+                break;
+            }
+            f->replay_pending = 1;
+        }
+        if(f->replay_speed > 0.0 && (double)f->replay_time * 1.0e-9 > elapsed)
+            break;
+
+        f->replay_pending = 0;
+        if(fread(f->payload, 1, f->replay_nbytes, f->replay) != f->replay_nbytes) {
+            lprintf("journal: truncated block after %zu sample(s)\n", f->replay_samples);
+            f->replay_done = 1;
+            break;
+        }
+        decode_block(f->payload, f->replay_nbytes, f->replay_codec, f->replay_count, f->batch);
+        follow_ingest(f, data, f->batch, f->replay_count);
+        f->replay_samples += f->replay_count;
+        added += f->replay_count;
+    }
+
+    if(f->replay_done && !f->replay_reported) {
+        elapsed = now_seconds() - f->replay_start;
+        lprintf("replay: %zu sample(s) in %.3f s, %.1f M samples/s\n", f->replay_samples, elapsed,
+            elapsed > 0.0 ? (double)f->replay_samples / elapsed * 1.0e-6 : 0.0);
+        f->replay_reported = 1;
+    }
+    return added;
+}
+
+/* takes in whatever complete lines were appended since the last call;
+ * lines that are not numbers are skipped rather than ending the data */
+static size_t poll_follow(struct follow_s *f, const struct graphdata_s *data)
+{
+    int round;
+    size_t n, batch, added = 0;
+    char *p, *next, *end, *last;
+    struct stat st;
+
+    if(f->replay) {
+        added = replay_follow(f, data);
+        if(added)
+            update_references(f);
+        return added;
+    }
+
+    for(round = 0; round < FOLLOW_ROUNDS; round++) {
+        n = fread(f->buffer + f->len, 1, FOLLOW_CHUNK - f->len, f->fp);
+        if(!n) {
+            clearerr(f->fp);
+
+            /* truncated underneath us: start over from the top */
+            if(!stat(f->filename, &st) && (uint64_t)st.st_size < f->offset) {
+                lprintf("%s: truncated, following from the start\n", f->filename);
+                fseek(f->fp, 0, SEEK_SET);
+                f->offset = 0;
+                f->len = 0;
+            }
+            break;
+        }
+
+        f->offset += n;
+        f->len += n;
+        last = f->buffer + f->len;
+        batch = 0;
+        for(p = f->buffer; (next = memchr(p, '\n', (size_t)(last - p))) != NULL; p = next + 1) {
+            *next = 0;
+            f->batch[batch] = strtof(p, &end);
+            if(end != p)
+                batch++;
+        }
+        follow_ingest(f, data, f->batch, batch);
+        if(f->journal && batch)
+            record_batch(f, f->batch, batch);
+        added += batch;
+
+        /* keep the partial line; one that fills the buffer is dropped */
+        f->len = (size_t)(last - p);
+        memmove(f->buffer, p, f->len);
+        if(f->len == FOLLOW_CHUNK)
+            f->len = 0;
+    }
+
+    if(added)
+        update_references(f);
+    return added;
+}
+
+/* draws samples from first_column on into the scroll texture, over
+ * whatever those columns held; a column is column_samples samples wide
+ * and lands at its index modulo the texture width */
+static void draw_columns(struct follow_s *f, const struct graphdata_s *data, size_t first_column, size_t last_column)
+{
+    int k, ox, pass, width = (int)(last_column - first_column + 1);
+    size_t j, n, start, slot, oldest = f->count > FOLLOW_WINDOW ? f->count - FOLLOW_WINDOW : 0;
+    float h = (float)HEIGHT - data->frame_px * 2;
+    double x0 = (double)first_column * (double)f->column_samples;
+    vec2_t *mesh = f->mesh;
+
+    /* one sample from the column before so the line joins up */
+    start = first_column * f->column_samples;
+    start = start > oldest ? start - 1 : oldest;
+    n = f->count - start;
+    for(j = 0; j < n; j++) {
+        slot = (start + j) & (FOLLOW_WINDOW - 1);
+        mesh[j][0] = (float)(((double)(start + j) - x0 + 0.5) / (double)f->column_samples);
+        mesh[j][1] = data->frame_px + f->ring[slot] / f->scale * h;
+        for(k = 0; k < f->num_overlays; k++) {
+            mesh[n * (size_t)(k + 1) + j][0] = mesh[j][0];
+            mesh[n * (size_t)(k + 1) + j][1] = data->frame_px + f->rings[k][slot] / f->scale * h;
+        }
+    }
+    if(n)
+        glNamedBufferSubData(glvbo, sizeof(vec2_t) * NUM_REFLINES * 2, sizeof(vec2_t) * n * (size_t)(f->num_overlays + 1), mesh);
+
+    /* the viewport puts x 0 at the first column; a second pass catches
+     * the columns that wrap around to the start of the texture */
+    glBindFramebuffer(GL_FRAMEBUFFER, glscrollfbo);
+    glEnable(GL_SCISSOR_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glLineWidth(data->line_width);
+    glBindVertexArray(glvao);
+    glUseProgram(glprogram);
+    for(pass = 0, ox = (int)(first_column % (size_t)f->columns); pass < 2 && ox < f->columns; pass++, ox -= f->columns) {
+        if(pass && ox + width <= 0)
+            break;
+        glScissor(ox, 0, width, HEIGHT);
+        glClear(GL_COLOR_BUFFER_BIT);
+        if(!n)
+            continue;
+        glViewport(ox, 0, WIDTH, HEIGHT);
+        set_color(SERIES_COLOR);
+        glDrawArrays(GL_LINE_STRIP, NUM_REFLINES * 2, (GLsizei)n);
+        for(k = 0; k < f->num_overlays; k++) {
+            set_color(data->overlays[k].color);
+            glDrawArrays(GL_LINE_STRIP, NUM_REFLINES * 2 + (GLint)(n * (size_t)(k + 1)), (GLsizei)n);
+        }
+    }
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/* the window scrolls through a texture: only the columns samples arrived
+ * in since the last call get drawn, plus the newest one, which is still
+ * filling up. the reference lines and axes go on top every time */
+static void upload_follow(struct follow_s *f, const struct graphdata_s *data)
+{
+    int k;
+    size_t first, last;
+    float top = f->window_max > 0.0f ? f->window_max : 1.0f, y, step;
+    float x0, w, h = (float)HEIGHT - data->frame_px * 2;
+    vec2_t lines[NUM_REFLINES * 2];
+
+    if(!f->allocated) {
+        f->x0 = (int)data->frame_px;
+        f->columns = WIDTH - f->x0 * 2 > 0 ? WIDTH - f->x0 * 2 : 1;
+        f->column_samples = FOLLOW_WINDOW / (size_t)f->columns;
+        glNamedBufferData(glvbo, sizeof(vec2_t) * (NUM_REFLINES * 2 + (FOLLOW_WINDOW + 1) * (size_t)(f->num_overlays + 1)), NULL, GL_DYNAMIC_DRAW);
+        if(!f->tiers[0].capacity)
+            create_scroll(f->columns);
+        f->allocated = 1;
+        f->scale = 0.0f;
+    }
+    if(f->tiers[0].capacity) {
+        upload_history(f, data);
+        return;
+    }
+
+    /* every column is drawn to the same scale, so it only moves when the
+     * window outgrows it or falls under half of it */
+    last = f->count / f->column_samples;
+    if(top > f->scale || top < f->scale * 0.5f) {
+        step = (float)nice_step(top, AXIS_TICKS);
+        f->scale = (float)ceil(top / step) * step;
+        first = last + 1 > (size_t)f->columns ? last + 1 - (size_t)f->columns : 0;
+        draw_columns(f, data, first, first + (size_t)f->columns - 1);
+    }
+    else if(last - f->column >= (size_t)f->columns)
+        draw_columns(f, data, last + 1 - (size_t)f->columns, last);
+    else
+        draw_columns(f, data, f->column, last);
+    f->column = last;
+
+    /* the newest column goes to the right edge */
+    x0 = (float)f->x0;
+    w = (float)f->columns;
+    glProgramUniform1f(glscrollprogram, 0, (float)((last + 1) % (size_t)f->columns) / w);
+    glProgramUniform4f(glscrollprogram, 1, x0, 0.0f, x0 + w, (float)HEIGHT);
+
+    for(k = 0; k < NUM_REFLINES; k++) {
+        y = (float)f->refs[k] / f->scale;
+        y = data->frame_px + (y < 1.0f ? y : 1.0f) * h;
+        lines[k * 2][0] = x0;
+        lines[k * 2 + 1][0] = x0 + w;
+        lines[k * 2][1] = lines[k * 2 + 1][1] = y;
+    }
+    glNamedBufferSubData(glvbo, 0, sizeof(lines), lines);
+    glnumstrips = 0;
+    for(k = 0; k < NUM_REFLINES; k++)
+        add_strip(GL_LINE_STRIP, (size_t)k * 2, 2, refline_colors[k]);
+
+    set_axes(((double)last + 1.0 - w) * (double)f->column_samples, ((double)last + 1.0) * (double)f->column_samples, 0.0, f->scale, 0.0);
+    upload_axes(data);
+}
+
+static void follow_title(struct follow_s *f, const char *filename)
+{
+    char title[512];
+    snprintf(title, sizeof(title), "UndGraph - %s - n %zu  p50 %g  p99 %g  p999 %g  max %g", filename,
+        f->count, f->refs[0], f->refs[1], f->refs[2], f->refs[3]);
+    glfwSetWindowTitle(window, title);
+    f->title_time = now_seconds();
+    f->dirty = 0;
+}
+
+static void apply_options(struct graphdata_s *data, const char *filename)
+{
+    if(options.force_msaa)
+        data->msaa = 1;
+    if(options.force_save)
+        data->save = 1;
+    if(options.force_compress)
+        data->compress = 1;
+    if(options.hist_bins)
+        data->hist_bins = options.hist_bins;
+    if(options.cdf)
+        data->cdf = 1;
+    if(options.fft_size)
+        data->fft_size = options.fft_size;
+    if(options.envelope)
+        data->envelope = 1;
+    if(options.axes)
+        data->axes = 1;
+    if(options.history)
+        data->history = options.history;
+
+    /* the text loader may have compressed already; anything that needs
+     * the samples flat decodes them and gives the copy back after */
+    if(data->hist_bins && data->size)
+        compute_histogram(data);
+    else if(data->fft_size)
+        compute_spectrum(data);
+    else {
+        compute_overlays(data);
+        if(data->envelope && data->size)
+            compute_envelope(data);
+    }
+
+    /* the text loader checks the rules as it gathers the values */
+    if(data->alerts.rules) {
+        if(!data->alerts_scanned && data->size)
+            compute_alerts(data);
+        if(data->alerts_scanned) {
+            finish_alerts(data);
+            report_alerts(data, filename);
+        }
+    }
+
+    if(data->compress && data->data)
+        compress_samples(data);
+}
+
+static void init_graphdata(struct graphdata_s *data, struct arena_s *arena)
+{
+    memset(data, 0, sizeof(struct graphdata_s));
+    data->arena = arena;
+    data->range_begin = options.range_begin;
+    data->range_end = options.range_end;
+    data->stride = options.stride;
+    data->build_index = options.build_index;
+    data->direct_io = options.direct_io;
+    data->alerts = options.alerts;
+}
+
+static void load_task(void *arg, size_t index)
+{
+    struct batchslot_s *slot = arg;
+    (void)index;
+    slot->loaded = read_undgraph(slot->filename, &slot->data);
+    if(slot->loaded)
+        apply_options(&slot->data, slot->filename);
+}
+
+struct diffload_s {
+    const char *filenames[2];
+    struct graphdata_s *data[2];
+    int loaded[2];
+};
+
+static void diff_load_task(void *arg, size_t index)
+{
+    struct diffload_s *job = arg;
+    job->loaded[index] = read_undgraph(job->filenames[index], job->data[index]);
+}
+
+/* --diff: both files load side by side, each into its own arena, and
+ * are compared once both are in */
+static int load_diff(struct graphdata_s *a, struct graphdata_s *b)
+{
+    int k;
+    double start = now_seconds();
+    struct diffload_s job;
+
+    for(k = 0; k < 2; k++) {
+        job.filenames[k] = options.diff_filenames[k];
+        job.loaded[k] = 0;
+    }
+    job.data[0] = a;
+    job.data[1] = b;
+    pool_parallel_for(2, &diff_load_task, &job);
+    if(!job.loaded[0] || !job.loaded[1])
+        return 0;
+
+    lprintf("diff: loaded %zu and %zu samples in %.1f ms\n", a->size, b->size, (now_seconds() - start) * 1000.0);
+    for(k = 0; k < 2; k++) {
+        if(!job.data[k]->size) {
+            lprintf("diff: %s has no samples\n", job.filenames[k]);
+            return 0;
+        }
+    }
+
+    a->diff_ratio = options.diff_ratio;
+    compute_diff(a, b);
+    return 1;
+}
+
+static void encode_task(void *arg, size_t index)
+{
+    struct batchslot_s *slot = arg;
+    char tmpstr[4096];
+    (void)index;
+    snprintf(tmpstr, sizeof(tmpstr), "%s.png", slot->filename);
+    slot->saved = write_png(tmpstr, slot->pixels, &slot->arena);
+}
+
+static void start_load(struct batchslot_s *slot, const char *filename)
+{
+    init_graphdata(&slot->data, &slot->arena);
+    slot->filename = filename;
+    slot->active = 1;
+    slot->loaded = 0;
+    slot->saved = 0;
+    slot->task.func = &load_task;
+    slot->task.arg = slot;
+    pool_submit(&slot->group, &slot->task);
+}
+
+/* waits until the slot's file is written out; returns 1 if it failed */
+static int finish_slot(struct batchslot_s *slot, size_t *allocs)
+{
+    int failed;
+
+    pool_wait(&slot->group);
+    failed = !slot->loaded || !slot->saved;
+    if(slot->loaded) {
+        free_samples(&slot->data);
+        lprintf("%s: %zu heap allocation(s), arena %.1f MiB\n", slot->filename, (size_t)atom_load(&heap_allocs) - *allocs,
+            (double)slot->arena.capacity / 1048576.0);
+    }
+
+    *allocs = (size_t)atom_load(&heap_allocs);
+    arena_reset(&slot->arena);
+    slot->active = 0;
+    return failed;
+}
+
+/* renders every file to a png with one hidden window; the next file
+ * loads and the previous one encodes while the current one renders */
+static int run_batch(void)
+{
+    int i, failed = 0, gl_failed = 0;
+    size_t allocs = 0;
+    struct batchslot_s slots[2], *cur, *next;
+
+    memset(slots, 0, sizeof(slots));
+    arena_init(&slots[0].arena);
+    arena_init(&slots[1].arena);
+
+    if(options.num_files)
+        start_load(&slots[0], options.files[0]);
+
+    for(i = 0; i < options.num_files; i++) {
+        cur = &slots[i & 1];
+        next = &slots[(i + 1) & 1];
+
+        /* the other slot's arena is reused once its png is out */
+        if(next->active)
+            failed += finish_slot(next, &allocs);
+        if(i + 1 < options.num_files)
+            start_load(next, options.files[i + 1]);
+
+        pool_wait(&cur->group);
+        if(!cur->loaded)
+            continue;
+
+        /* msaa is a property of the window, so the first file decides */
+        if(!window && !init_gl("UndGraph - batch", cur->data.msaa, 0)) {
+            gl_failed = 1;
+            break;
+        }
+
+        upload_graph(&cur->data);
+        draw_graph(&cur->data);
+        cur->pixels = read_pixels(&cur->arena);
+        cur->task.func = &encode_task;
+        cur->task.arg = cur;
+        pool_submit(&cur->group, &cur->task);
+    }
+
+    for(i = 0; i < 2; i++) {
+        cur = &slots[(options.num_files + i) & 1];
+        if(cur->active)
+            failed += finish_slot(cur, &allocs);
+        arena_destroy(&cur->arena);
+    }
+
+    if(window)
+        shutdown_gl();
+
+    print_pool_stats();
+    lprintf("batch: %d file(s), %d failed\n", options.num_files, failed);
+    return (failed || gl_failed) ? 1 : 0;
+}
+
+/* a thumbnail in the unit square, low to high: every sample when there
+ * are few, else the low and the high of each pixel column in turn */
+static size_t thumbnail_mesh(const struct graphdata_s *data, vec2_t *mesh)
+{
+    size_t c, i, first, last, n = 0;
+    float lo, hi, range = data->max_value - data->min_value;
+    const float *values = flat_samples(data);
+
+    range = range > 0.0f ? range : 1.0f;
+    if(data->size <= SHEET_CELL_W * 2) {
+        for(i = 0; i < data->size; i++) {
+            mesh[i][0] = data->size > 1 ? (float)i / (float)(data->size - 1) : 0.5f;
+            mesh[i][1] = (values[i] - data->min_value) / range;
+        }
+        return data->size;
+    }
+
+    for(c = 0; c < SHEET_CELL_W; c++) {
+        first = c * data->size / SHEET_CELL_W;
+        last = (c + 1) * data->size / SHEET_CELL_W;
+        reduce_minmax(values + first, last - first, &lo, &hi);
+        if(lo > hi)
+            continue; /* nothing but nans */
+        mesh[n][0] = mesh[n + 1][0] = ((float)c + 0.5f) / (float)SHEET_CELL_W;
+        mesh[n][1] = (lo - data->min_value) / range;
+        mesh[n + 1][1] = (hi - data->min_value) / range;
+        n += 2;
+    }
+    return n;
+}
+
+/* loads files until none are left, each into the arena of this task
+ * and only for as long as its thumbnail takes */
+static void sheet_task(void *arg, size_t index)
+{
+    size_t i;
+    struct sheetjob_s *job = arg;
+    struct arena_s arena;
+    struct graphdata_s data;
+    (void)index;
+
+    arena_init(&arena);
+    while((i = (size_t)atom_add(&job->next, 1) - 1) < job->num_files) {
+        init_graphdata(&data, &arena);
+        if(read_undgraph(job->filenames[i], &data))
+            job->cmds[i].count = (GLuint)thumbnail_mesh(&data, job->mesh + job->cmds[i].first);
+        else
+            atom_add(&job->failed, 1);
+        free_samples(&data);
+        arena_reset(&arena);
+    }
+    arena_destroy(&arena);
+}
+
+/* --sheet OUT: every file as a thumbnail on one canvas, written once.
+ * the files load pool_width() at a time straight into one vertex
+ * buffer; the cell outlines are one instanced draw and the plots one
+ * indirect multi-draw. the canvas streams out in bands of rows, so it
+ * is never in memory whole */
+static int run_sheet(void)
+{
+    int ok = 0;
+    size_t i, n = (size_t)options.num_files, columns, rows, stride = SHEET_CELL_W * 2;
+    GLsizei width, height, top, band;
+    GLuint vs, fs, program, vao, fbo, rbo, buffers[3];
+    double start = now_seconds(), load_time, draw_time;
+    float *cells;
+    char *pixels;
+    FILE *fp;
+    struct pngwriter_s png;
+    struct sheetjob_s job;
+    static const vec2_t outline[5] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f }, { 0.0f, 0.0f } };
+
+    if(!n) {
+        lprintf("--sheet: no files\n");
+        return 1;
+    }
+
+    columns = (size_t)ceil(sqrt((double)n));
+    columns = columns < SHEET_MAX_SIZE / SHEET_CELL_W ? columns : SHEET_MAX_SIZE / SHEET_CELL_W;
+    rows = (n + columns - 1) / columns;
+    if(rows * SHEET_CELL_H > SHEET_MAX_SIZE) {
+        lprintf("--sheet: %zu files do not fit on a %d pixel canvas\n", n, SHEET_MAX_SIZE);
+        return 1;
+    }
+    width = (GLsizei)(columns * SHEET_CELL_W);
+    height = (GLsizei)(rows * SHEET_CELL_H);
+
+    /* the first file in the top left corner; the outline goes last */
+    job.filenames = options.files;
+    job.num_files = n;
+    job.next = 0;
+    job.failed = 0;
+    job.mesh = arena_alloc(&file_arena, sizeof(vec2_t) * (n * stride + 5));
+    job.cmds = arena_alloc(&file_arena, sizeof(struct drawcmd_s) * n);
+    cells = arena_alloc(&file_arena, sizeof(float) * 4 * n);
+    for(i = 0; i < n; i++) {
+        job.cmds[i].count = 0;
+        job.cmds[i].instance_count = 1;
+        job.cmds[i].first = (GLuint)(i * stride);
+        job.cmds[i].base_instance = (GLuint)i;
+        cells[i * 4] = (float)((i % columns) * SHEET_CELL_W + SHEET_PAD);
+        cells[i * 4 + 1] = (float)((size_t)height - (i / columns + 1) * SHEET_CELL_H + SHEET_PAD);
+        cells[i * 4 + 2] = (float)(SHEET_CELL_W - SHEET_PAD * 2);
+        cells[i * 4 + 3] = (float)(SHEET_CELL_H - SHEET_PAD * 2);
+    }
+    memcpy(job.mesh + n * stride, outline, sizeof(outline));
+
+    pool_parallel_for((size_t)pool_width() < n ? (size_t)pool_width() : n, &sheet_task, &job);
+    load_time = now_seconds() - start;
+
+    if(!window && !init_gl("UndGraph - sheet", 0, 0))
+        return 1;
+    start = now_seconds();
+
+    vs = compile_shader(GL_VERTEX_SHADER, glsl_sheet_v);
+    fs = compile_shader(GL_FRAGMENT_SHADER, glsl_f);
+    program = vs && fs ? link_program(vs, fs) : 0;
+    glDeleteShader(fs);
+    glDeleteShader(vs);
+    if(!program) {
+        shutdown_gl();
+        return 1;
+    }
+
+    glCreateBuffers(3, buffers);
+    glNamedBufferData(buffers[0], (GLsizeiptr)(sizeof(vec2_t) * (n * stride + 5)), job.mesh, GL_STATIC_DRAW);
+    glNamedBufferData(buffers[1], (GLsizeiptr)(sizeof(float) * 4 * n), cells, GL_STATIC_DRAW);
+    glNamedBufferData(buffers[2], (GLsizeiptr)(sizeof(struct drawcmd_s) * n), job.cmds, GL_STATIC_DRAW);
+
+    glCreateVertexArrays(1, &vao);
+    glVertexArrayVertexBuffer(vao, 0, buffers[0], 0, sizeof(vec2_t));
+    glVertexArrayVertexBuffer(vao, 1, buffers[1], 0, sizeof(float) * 4);
+    glVertexArrayBindingDivisor(vao, 1, 1);
+    glEnableVertexArrayAttrib(vao, 0);
+    glEnableVertexArrayAttrib(vao, 1);
+    glVertexArrayAttribFormat(vao, 0, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribFormat(vao, 1, 4, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+    glVertexArrayAttribBinding(vao, 1, 1);
+
+    glCreateRenderbuffers(1, &rbo);
+    glNamedRenderbufferStorage(rbo, GL_RGBA8, width, height);
+    glCreateFramebuffers(1, &fbo);
+    glNamedFramebufferRenderbuffer(fbo, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo);
+
+    if(glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glLineWidth(1.0f);
+        glBindVertexArray(vao);
+        glUseProgram(program);
+        glProgramUniform2f(program, 1, (float)width, (float)height);
+
+        set_program_color(program, GRID_COLOR);
+        glDrawArraysInstanced(GL_LINE_STRIP, (GLint)(n * stride), 5, (GLsizei)n);
+        set_program_color(program, SERIES_COLOR);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffers[2]);
+        glMultiDrawArraysIndirect(GL_LINE_STRIP, NULL, (GLsizei)n, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+        glFinish();
+        draw_time = now_seconds() - start;
+
+        /* read back a band of rows at a time from the top, each band
+         * bottom-up, and stream it out */
+        start = now_seconds();
+        fp = fopen(options.sheet_filename, "wb");
+        if(fp && png_begin(&png, width, height, 3, &png_fwrite, fp, &file_arena)) {
+            pixels = arena_alloc(&file_arena, (size_t)width * 3 * PNG_BAND_ROWS);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            for(top = 0; top < height; top += band) {
+                band = height - top < PNG_BAND_ROWS ? height - top : PNG_BAND_ROWS;
+                glReadPixels(0, height - top - band, width, band, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+                png_rows(&png, (const unsigned char *)pixels + (size_t)(band - 1) * (size_t)width * 3, band, -(ptrdiff_t)width * 3);
+            }
+            ok = png_end(&png);
+        }
+        if(fp)
+            ok = !fclose(fp) && ok;
+        else
+            lprintf("%s: %s\n", options.sheet_filename, strerror(errno));
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, WIDTH, HEIGHT);
+
+        lprintf("sheet: %zu file(s), %d failed, %dx%d, load %.1f ms, draw %.1f ms, encode %.1f ms\n", n, (int)job.failed,
+            width, height, load_time * 1000.0, draw_time * 1000.0, (now_seconds() - start) * 1000.0);
+    }
+    else
+        lprintf("--sheet: a %dx%d framebuffer is not supported\n", width, height);
+
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &rbo);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(3, buffers);
+    glDeleteProgram(program);
+    shutdown_gl();
+    return !ok || job.failed;
+}
+
+/* full range bt.601 as y4m's C420jpeg wants it, chroma from each 2x2
+ * block; the rows come bottom-up from the readback */
+static void rgb_to_yuv(const char *pixels, unsigned char *yuv)
 {
-    va_list va;
-    va_start(va, fmt);
-    vfprintf(stderr, fmt, va);
-    va_end(va);
+    int x, y, r, g, b;
+    const unsigned char *row, *next, *rgb = (const unsigned char *)pixels;
+    unsigned char *luma = yuv, *u = yuv + WIDTH * HEIGHT, *v = u + WIDTH * HEIGHT / 4;
+
+    for(y = 0; y < HEIGHT; y++) {
+        row = rgb + (size_t)(HEIGHT - 1 - y) * WIDTH * 3;
+        for(x = 0; x < WIDTH; x++, row += 3)
+            *luma++ = (unsigned char)((77 * row[0] + 150 * row[1] + 29 * row[2] + 128) >> 8);
+    }
+
+    for(y = 0; y < HEIGHT; y += 2) {
+        row = rgb + (size_t)(HEIGHT - 1 - y) * WIDTH * 3;
+        next = row - WIDTH * 3;
+        for(x = 0; x < WIDTH; x += 2, row += 6, next += 6) {
+            r = row[0] + row[3] + next[0] + next[3];
+            g = row[1] + row[4] + next[1] + next[4];
+            b = row[2] + row[5] + next[2] + next[5];
+            *u++ = (unsigned char)((-43 * r - 84 * g + 127 * b + 4 * 32896) >> 10);
+            *v++ = (unsigned char)((127 * r - 106 * g - 21 * b + 4 * 32896) >> 10);
+        }
+    }
 }
 
-static void on_glfw_error(int code, const char *message)
+static void frame_task(void *arg, size_t index)
 {
-    lprintf("GLFW error %d: %s\n", code, message);
+    struct frameslot_s *slot = arg;
+    char tmpstr[4096];
+    (void)index;
+
+    if(options.y4m) {
+        slot->yuv = arena_alloc(&slot->arena, WIDTH * HEIGHT * 3 / 2);
+        rgb_to_yuv(slot->pixels, slot->yuv);
+        slot->saved = 1;
+        return;
+    }
+
+    snprintf(tmpstr, sizeof(tmpstr), "%s.%06zu.png", slot->filename, slot->frame);
+    slot->saved = write_png(tmpstr, slot->pixels, &slot->arena);
 }
 
-static int read_undgraph(const char *filename, struct graphdata_s *data)
+/* waits for the slot's frame and writes it out if it goes to the y4m
+ * stream, which takes the frames in order; returns 1 if it failed */
+static int finish_frame(struct frameslot_s *slot)
 {
-    int nc, nr;
-    float f;
-    size_t i;
-    char line[64], tag[32];
-    const char *lp;
-    FILE *fp;
-    
-    fp = fopen(filename, "r");
-    if(!fp) {
-        lprintf("%s\n", strerror(errno));
-        return 0;
+    pool_wait(&slot->group);
+    if(slot->saved && options.y4m) {
+        fputs("FRAME\n", stdout);
+        slot->saved = fwrite(slot->yuv, WIDTH * HEIGHT * 3 / 2, 1, stdout) == 1;
     }
 
-    /* default tag values */
-    data->msaa = 0;
-    data->save = 0;
-    data->line_width = 1.0f;
-    data->frame_px = 0;
+    arena_reset(&slot->arena);
+    slot->active = 0;
+    return !slot->saved;
+}
 
-    /* header */
-    nc = 0;
-    lp = fgets(line, sizeof(line), fp);
-    i = strlen(lp);
+/* --animate W[:S]: a window of W samples panned S at a time across the
+ * series, out as numbered pngs or a y4m stream on stdout. the mesh goes
+ * up once and each frame only moves the view. frame i reads back into
+ * one pixel buffer while frame i-1 maps out of the other and goes to an
+ * encoder, with ANIM_SLOTS frames encoding at once */
+static int run_animate(struct graphdata_s *data, const char *filename)
+{
+    int k, failed = 0;
+    size_t i, num_frames, span, step, bytes = 3 * WIDTH * HEIGHT;
+    double start;
+    const void *mapped;
+    GLuint pbo[2];
+    struct frameslot_s slots[ANIM_SLOTS], *slot;
 
-    /* header: magic */
-    sscanf(lp += nc, "%31s %n", tag, &nc);
-    if(strcmp(tag, "undgraph")) {
-        lprintf("%s: invalid header format\n");
-        goto error;
+    if(data->histogram || data->spectrum || data->columns || data->delta) {
+        lprintf("--animate: only the series view pans\n");
+        return 0;
+    }
+    if(!data->size) {
+        lprintf("--animate: no samples\n");
+        return 0;
     }
 
-    /* header: tags */
-    while((size_t)(lp - line) < i && (nr = sscanf(lp += nc, " %31s %n", tag, &nc)) > 0) {
-        if(strstr(tag, "msaa") == tag) {
-            sscanf(tag, "msaa:%d", &data->msaa);
-            continue;
-        }
+    span = options.anim_window < data->size ? options.anim_window : data->size;
+    step = options.anim_step ? options.anim_step : span / ANIM_STEP ? span / ANIM_STEP : 1;
+    num_frames = (data->size - span) / step + 1;
 
-        if(strstr(tag, "save") == tag) {
-            sscanf(tag, "save:%d", &data->save);
-            continue;
-        }
+    if(!window && !init_gl("UndGraph - animate", data->msaa, 0))
+        return 0;
+    upload_graph(data);
+    glCreateBuffers(2, pbo);
+    for(k = 0; k < 2; k++)
+        glNamedBufferData(pbo[k], (GLsizeiptr)bytes, NULL, GL_STREAM_READ);
 
-        if(strstr(tag, "lw") == tag) {
-            sscanf(tag, "lw:%f", &data->line_width);
-            continue;
+    memset(slots, 0, sizeof(slots));
+    for(k = 0; k < ANIM_SLOTS; k++)
+        arena_init(&slots[k].arena);
+
+    if(options.y4m) {
+#if defined(_WIN32)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        printf("YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", WIDTH, HEIGHT, ANIM_FPS);
+    }
+
+    start = now_seconds();
+    for(i = 0; i <= num_frames; i++) {
+        if(i < num_frames) {
+            set_view(data, i * step, span);
+            draw_graph(data);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[i & 1]);
+            glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
         }
+        if(!i)
+            continue;
 
-        if(strstr(tag, "frame_px") == tag) {
-            sscanf(tag, "frame_px:%f", &data->frame_px);
+        /* the previous frame, whose readback had this one's draw to
+         * hide behind */
+        slot = slots + (i - 1) % ANIM_SLOTS;
+        if(slot->active)
+            failed += finish_frame(slot);
+        mapped = glMapNamedBufferRange(pbo[(i - 1) & 1], 0, (GLsizeiptr)bytes, GL_MAP_READ_BIT);
+        if(!mapped) {
+            failed++;
             continue;
         }
+        slot->pixels = arena_alloc(&slot->arena, bytes);
+        memcpy(slot->pixels, mapped, bytes);
+        glUnmapNamedBuffer(pbo[(i - 1) & 1]);
 
-        lprintf("%s: warning: unknown tag: %s\n", tag);
+        slot->filename = filename;
+        slot->frame = i - 1;
+        slot->active = 1;
+        slot->saved = 0;
+        slot->task.func = &frame_task;
+        slot->task.arg = slot;
+        pool_submit(&slot->group, &slot->task);
     }
 
-    /* line count */
-    data->size = 0;
-    while(fgets(line, sizeof(line), fp)) {
-        if(sscanf(line, "%f", &f) != 1)
-            break;
-        data->size++;
+    for(k = 0; k < ANIM_SLOTS; k++) {
+        slot = slots + (num_frames + (size_t)k) % ANIM_SLOTS;
+        if(slot->active)
+            failed += finish_frame(slot);
+        arena_destroy(&slot->arena);
     }
+    if(options.y4m)
+        fflush(stdout);
 
-    lprintf("%s: found %zu values\n", filename, data->size);
-    fseek(fp, 0, SEEK_SET);
+    lprintf("animate: %zu frame(s) of %zu samples, %d failed, %.1f fps\n", num_frames, span, failed,
+        (double)num_frames / (now_seconds() - start));
+
+    glDeleteBuffers(2, pbo);
+    glpanning = 0;
+    shutdown_gl();
+    return !failed;
+}
 
-    /* allocate */
-    data->data = malloc(sizeof(float) * data->size);
-    assert(("Out of memory!", data->data));
+/* --summary: count, mean and m2 per worker, merged pairwise */
+struct moments_s {
+    size_t count;
+    double mean;
+    double m2;
+    float min_value;
+    float max_value;
+};
 
-    /* skip the header */
-    fgets(line, sizeof(line), fp);
+/* the first pass takes the moments and the top digit of every key, the
+ * next two the following digits of the keys that still match each
+ * quantile's prefix */
+struct selectjob_s {
+    const struct graphdata_s *data;
+    float *scratch;
+    int pass;
+    uint32_t prefix[NUM_QUANTILES];
+    size_t *bins;
+    struct moments_s *moments;
+    size_t *nans;
+};
 
-    /* read the graph data */
-    i = 0;
-    f = 0.0f;
-    data->max_value = FLT_MIN;
-    data->min_value = FLT_MAX;
-    while(fgets(line, sizeof(line), fp) && i < data->size) {
-        f = strtof(line, NULL);
-        if(f > data->max_value)
-            data->max_value = f;
-        if(f < data->min_value)
-            data->min_value = f;
-        data->data[i++] = f;
-    }
+/* floats as unsigned keys in the same order */
+static uint32_t float_key(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000U) ? ~bits : bits | 0x80000000U;
+}
 
-    data->tick_size = fabsf(data->max_value - data->min_value) / (float)data->size;
+static float key_float(uint32_t key)
+{
+    float value;
+    key = (key & 0x80000000U) ? key & 0x7FFFFFFFU : ~key;
+    memcpy(&value, &key, sizeof(value));
+    return value;
+}
 
-    fclose(fp);
-    return 1;
+static void merge_moments(struct moments_s *a, const struct moments_s *b)
+{
+    double delta = b->mean - a->mean;
+    size_t n = a->count + b->count;
 
-error:
-    fclose(fp);
-    return 0;
+    if(!b->count)
+        return;
+    if(!a->count || b->min_value < a->min_value)
+        a->min_value = b->min_value;
+    if(!a->count || b->max_value > a->max_value)
+        a->max_value = b->max_value;
+    a->m2 += b->m2 + delta * delta * (double)a->count * (double)b->count / (double)n;
+    a->mean += delta * (double)b->count / (double)n;
+    a->count = n;
 }
 
-static GLuint compile_shader(GLenum stage, const char *source)
+static void select_blocks(void *arg, size_t first, size_t last)
 {
-    char *info_log;
-    GLuint shader;
-    GLint gli;
-    
-    shader = glCreateShader(stage);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
+    struct selectjob_s *job = arg;
+    size_t block, count, j, nans;
+    size_t *bins = job->bins + (size_t)worker_index * NUM_QUANTILES * SELECT_BINS;
+    float *scratch = job->scratch + (size_t)worker_index * SAMPLES_PER_BLOCK;
+    const float *values;
+    uint32_t key;
+    int q;
+    struct moments_s m;
 
-    /* check info log */
-    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &gli);
-    if(gli > 1) {
-        info_log = malloc(gli + 1);
-        assert(("Out of memory!", info_log));
-        info_log[gli] = 0;
-        glGetShaderInfoLog(shader, gli, NULL, info_log);
-        lprintf("%s\n", info_log);
-        free(info_log);
+    for(block = first; block < last; block++) {
+        values = get_block(job->data, block, scratch, &count);
+
+        if(job->pass == 0) {
+            /* the block is still in cache for the second sweep */
+            m.count = 0;
+            m.mean = m.m2 = 0.0;
+            m.min_value = FLT_MAX;
+            m.max_value = -FLT_MAX;
+            for(nans = 0, j = 0; j < count; j++) {
+                if(isnan(values[j])) {
+                    nans++;
+                    continue;
+                }
+                if(values[j] < m.min_value)
+                    m.min_value = values[j];
+                if(values[j] > m.max_value)
+                    m.max_value = values[j];
+                m.mean += values[j];
+                bins[float_key(values[j]) >> (32 - SELECT_BITS)]++;
+            }
+            m.count = count - nans;
+            m.mean = m.count ? m.mean / (double)m.count : 0.0;
+            for(j = 0; j < count; j++)
+                if(!isnan(values[j]))
+                    m.m2 += (values[j] - m.mean) * (values[j] - m.mean);
+            merge_moments(job->moments + worker_index, &m);
+            job->nans[worker_index] += nans;
+            continue;
+        }
+
+        for(j = 0; j < count; j++) {
+            if(isnan(values[j]))
+                continue;
+            key = float_key(values[j]);
+            for(q = 0; q < NUM_QUANTILES; q++) {
+                if(job->pass == 1 && key >> (32 - SELECT_BITS) == job->prefix[q])
+                    bins[q * SELECT_BINS + ((key >> (32 - SELECT_BITS * 2)) & (SELECT_BINS - 1))]++;
+                else if(job->pass == 2 && key >> (32 - SELECT_BITS * 2) == job->prefix[q])
+                    bins[q * SELECT_BINS + (key & ((1U << (32 - SELECT_BITS * 2)) - 1))]++;
+            }
+        }
     }
+}
 
-    /* check status */
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &gli);
-    if(gli != GL_TRUE) {
-        glDeleteShader(shader);
-        return 0;
+/* exact quantiles by radix selection: three passes over the blocks,
+ * each narrowing every quantile's key by one digit with per worker
+ * histograms. nothing is copied or sorted, so the samples can stay
+ * compressed */
+static void summarize(const struct graphdata_s *data, struct moments_s *moments, size_t *nans, float *quantiles)
+{
+    int q, k, workers = pool_width();
+    size_t b, total, rank[NUM_QUANTILES], bins_per_pass = (size_t)NUM_QUANTILES * SELECT_BINS;
+    const size_t *bins;
+    struct selectjob_s job;
+    struct nodejob_s nodes;
+
+    *nans = 0;
+    job.data = data;
+    job.scratch = arena_alloc(data->arena, sizeof(float) * SAMPLES_PER_BLOCK * (size_t)workers);
+    job.bins = arena_alloc(data->arena, sizeof(size_t) * bins_per_pass * (size_t)workers);
+    job.moments = arena_alloc(data->arena, sizeof(struct moments_s) * (size_t)workers);
+    job.nans = arena_alloc(data->arena, sizeof(size_t) * (size_t)workers);
+    memset(job.moments, 0, sizeof(struct moments_s) * (size_t)workers);
+    memset(job.nans, 0, sizeof(size_t) * (size_t)workers);
+
+    for(job.pass = 0; job.pass < 3; job.pass++) {
+        memset(job.bins, 0, sizeof(size_t) * bins_per_pass * (size_t)workers);
+        pool_for_nodes(&nodes, count_blocks(data), sizeof(float) * SAMPLES_PER_BLOCK, &select_blocks, &job);
+
+        /* the workers' histograms go into the first one */
+        for(k = 1; k < workers; k++)
+            for(b = 0; b < bins_per_pass; b++)
+                job.bins[b] += job.bins[k * bins_per_pass + b];
+
+        if(job.pass == 0) {
+            memset(moments, 0, sizeof(struct moments_s));
+            for(k = 0; k < workers; k++) {
+                merge_moments(moments, job.moments + k);
+                *nans += job.nans[k];
+            }
+            if(!moments->count)
+                break;
+
+            /* nearest rank; the first pass has only the one histogram */
+            for(q = 0; q < NUM_QUANTILES; q++) {
+                rank[q] = (size_t)ceil(summary_quantiles[q] * (double)moments->count);
+                rank[q] = rank[q] ? rank[q] - 1 : 0;
+                job.prefix[q] = 0;
+            }
+        }
+
+        for(q = 0; q < NUM_QUANTILES; q++) {
+            bins = job.bins + (job.pass ? (size_t)q * SELECT_BINS : 0);
+            for(b = 0, total = 0; total + bins[b] <= rank[q]; b++)
+                total += bins[b];
+            rank[q] -= total;
+            job.prefix[q] = (job.prefix[q] << (job.pass == 2 ? 32 - SELECT_BITS * 2 : SELECT_BITS)) | (uint32_t)b;
+        }
     }
 
-    return shader;
+    for(q = 0; q < NUM_QUANTILES; q++)
+        quantiles[q] = moments->count ? key_float(job.prefix[q]) : 0.0f;
+    arena_free(data->arena, job.nans);
 }
 
-static GLuint link_program(GLuint vs, GLuint fs)
+static void print_json_string(const char *text)
 {
-    char *info_log;
-    GLuint program;
-    GLint gli;
+    putchar('"');
+    for(; *text; text++) {
+        if(*text == '"' || *text == '\\')
+            printf("\\%c", *text);
+        else if((unsigned char)*text < 0x20)
+            printf("\\u%04x", (unsigned)(unsigned char)*text);
+        else
+            putchar(*text);
+    }
+    putchar('"');
+}
 
-    program = glCreateProgram();
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
+/* one line per file, a table row or a json object; with no numbers to
+ * go on the table has - and json null */
+static void print_summary(const struct graphdata_s *data, const char *filename)
+{
+    int q;
+    size_t nans;
+    double start = now_seconds();
+    float quantiles[NUM_QUANTILES];
+    struct moments_s moments;
 
-    /* check info log */
-    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &gli);
-    if(gli > 1) {
-        info_log = malloc(gli + 1);
-        assert(("Out of memory!", info_log));
-        info_log[gli] = 0;
-        glGetProgramInfoLog(program, gli, NULL, info_log);
-        lprintf("%s\n", info_log);
-        free(info_log);
-    }
+    summarize(data, &moments, &nans, quantiles);
 
-    /* check status */
-    glGetProgramiv(program, GL_LINK_STATUS, &gli);
-    if(gli != GL_TRUE) {
-        glDeleteProgram(program);
-        return 0;
+    if(options.json) {
+        printf("{\"file\": ");
+        print_json_string(filename);
+        printf(", \"count\": %zu, \"nan\": %zu", moments.count, nans);
+        if(moments.count) {
+            printf(", \"min\": %.9g, \"max\": %.9g, \"mean\": %.17g, \"stddev\": %.17g", moments.min_value, moments.max_value,
+                moments.mean, sqrt(moments.m2 / (double)moments.count));
+            for(q = 0; q < NUM_QUANTILES; q++)
+                printf(", \"%s\": %.9g", summary_names[q], quantiles[q]);
+        }
+        else {
+            printf(", \"min\": null, \"max\": null, \"mean\": null, \"stddev\": null");
+            for(q = 0; q < NUM_QUANTILES; q++)
+                printf(", \"%s\": null", summary_names[q]);
+        }
+        printf("}\n");
+    }
+    else if(moments.count) {
+        printf("%s %zu %zu %.9g %.9g %.9g %.9g", filename, moments.count, nans, moments.min_value, moments.max_value,
+            moments.mean, sqrt(moments.m2 / (double)moments.count));
+        for(q = 0; q < NUM_QUANTILES; q++)
+            printf(" %.9g", quantiles[q]);
+        printf("\n");
     }
+    else
+        printf("%s 0 %zu - - - - - - - -\n", filename, nans);
 
-    return program;
+    lprintf("summary: %zu samples in %.1f ms\n", data->size, (now_seconds() - start) * 1000.0);
 }
 
-static const char *bool_to_string(int value)
+/* --summary: the numbers for every file, with no window and nothing
+ * drawn; one file at a time through the file arena */
+static int run_summary(void)
 {
-    if(value)
-        return "true";
-    return "false";
+    int i, failed = 0;
+
+    if(!options.json)
+        printf("file count nan min max mean stddev p50 p90 p99 p999\n");
+    for(i = 0; i < options.num_files; i++) {
+        init_graphdata(&graphdata, &file_arena);
+        if(read_undgraph(options.files[i], &graphdata))
+            print_summary(&graphdata, options.files[i]);
+        else
+            failed++;
+        free_samples(&graphdata);
+        arena_reset(&file_arena);
+    }
+    fflush(stdout);
+    return failed ? 1 : 0;
+}
+
+/* --bench --replay: the journal through the ingest path as fast as it
+ * decodes, with nothing drawn */
+static int run_replay(struct graphdata_s *data, const char *filename)
+{
+    struct follow_s f;
+
+    options.replay_speed = 0.0;
+    if(!start_follow(&f, data, filename))
+        return 0;
+    while(!f.replay_done)
+        poll_follow(&f, data);
+    stop_follow(&f);
+    return 1;
 }
 
 int main(int argc, char **argv)
 {
-    size_t i;
-    vec2_t *mesh;
-    GLuint vs, fs;
-    char tmpstr[128] = { 0 };
+    int status;
+    char tmpstr[4096] = { 0 };
     const char *filename;
-    char *pixels;
+    struct follow_s follow;
+    struct arena_s diff_arena;
+    struct graphdata_s diffdata;
+
+    options.files = malloc(sizeof(const char *) * argc);
+    assert(("Out of memory!", options.files));
+    if(!parse_args(argc, argv, &options))
+        return 1;
 
-    if(argc > 1) {
-        lprintf("reading %s\n", argv[1]);
-        filename = argv[1];
+    if(options.alerts_filename) {
+        alert_file = fopen(options.alerts_filename, "w");
+        if(!alert_file) {
+            lprintf("%s: %s\n", options.alerts_filename, strerror(errno));
+            return 1;
+        }
     }
-    else {
-        lprintf("no undgraph file specified, using default: undgraph.txt\n");
-        filename = "undgraph.txt";
+
+    pool_init();
+    arena_init(&file_arena);
+    init_graphdata(&graphdata, &file_arena);
+
+    if(options.summary) {
+        if(!options.num_files)
+            options.files[options.num_files++] = "undgraph.txt";
+        status = run_summary();
+        arena_destroy(&file_arena);
+        pool_shutdown();
+        return status;
     }
 
-    if(!read_undgraph(filename, &graphdata))
-        return 1;
+    if(options.sheet_filename) {
+        status = run_sheet();
+        arena_destroy(&file_arena);
+        pool_shutdown();
+        return status;
+    }
 
-    for(i = 2; i < (size_t)argc; i++) {
-        if(!strcmp(argv[i], "forcemsaa")) {
-            graphdata.msaa = 1;
-            continue;
-        }
-        if(!strcmp(argv[i], "forcesave")) {
-            graphdata.save = 1;
-            continue;
-        }
+    if(options.batch) {
+        status = run_batch();
+        arena_destroy(&file_arena);
+        pool_shutdown();
+        return status;
     }
 
-    lprintf("window: %dx%d\n", WIDTH, HEIGHT);
-    lprintf("color: #%02X%02X%02XFF\n", COLOR_R, COLOR_G, COLOR_B);
-    lprintf("msaa: %s\n", bool_to_string(graphdata.msaa));
-    lprintf("save: %s\n", bool_to_string(graphdata.save));
-    lprintf("line_width: %f\n", graphdata.line_width);
-    lprintf("frame_px: %f\n", graphdata.frame_px);
+    if(options.diff_filenames[0] && options.num_files)
+        lprintf("warning: only the two --diff files are shown\n");
+    else if(options.num_files > 1)
+        lprintf("warning: only the first file is shown without --batch\n");
 
-    if(graphdata.frame_px <= FLT_EPSILON) {
-        /* this can cause the graph to sometimes go off limits */
-        lprintf("note: frame_px is close to zero. too bad!\n");
+    if(options.diff_filenames[0]) {
+        lprintf("comparing %s and %s\n", options.diff_filenames[0], options.diff_filenames[1]);
+        filename = options.diff_filenames[0];
+    }
+    else if(options.num_files) {
+        lprintf("reading %s\n", options.files[0]);
+        filename = options.files[0];
+    }
+    else {
+        lprintf("no undgraph file specified, using default: undgraph.txt\n");
+        filename = "undgraph.txt";
     }
 
-    glfwSetErrorCallback(&on_glfw_error);
-    if(!glfwInit())
+    if(options.diff_filenames[0]) {
+        arena_init(&diff_arena);
+        init_graphdata(&diffdata, &diff_arena);
+        if(!load_diff(&graphdata, &diffdata))
+            return 1;
+    }
+    else if(!read_undgraph(filename, &graphdata))
         return 1;
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-    glfwWindowHint(GLFW_SAMPLES, graphdata.msaa ? 4 : 0);
+    apply_options(&graphdata, filename);
+    print_pool_stats();
 
-    snprintf(tmpstr, sizeof(tmpstr), "UndGraph - %s", filename);
-    window = glfwCreateWindow(WIDTH, HEIGHT, tmpstr, NULL, NULL);
-    if(!window) {
-        glfwTerminate();
-        return 1;
+    /* --check: fails on any alert, without opening a window */
+    if(options.check) {
+        if(!graphdata.alerts.rules)
+            lprintf("--check: no alert rules given\n");
+        status = !graphdata.alerts.rules || graphdata.alert_list.count;
+        free_samples(&graphdata);
+        return status;
     }
 
-    glfwMakeContextCurrent(window);
-    if(!gladLoadGL(glfwGetProcAddress)) {
-        lprintf("gladLoadGL failed\n");
-        goto error;
+    if(options.bench && options.replay_filename) {
+        status = run_replay(&graphdata, filename);
+        free_samples(&graphdata);
+        return status ? 0 : 1;
     }
 
-    lprintf("GL_VERSION: %s\n", glGetString(GL_VERSION));
+    if(options.bench) {
+        run_bench(&graphdata);
+        free_samples(&graphdata);
+        return 0;
+    }
 
-    vs = compile_shader(GL_VERTEX_SHADER, glsl_v);
-    fs = compile_shader(GL_FRAGMENT_SHADER, glsl_f);
-    if(!vs || !fs) {
-        lprintf("shader compilation failed\n");
-        goto error;
+    if(options.pack_filename) {
+        status = write_undgraph_blocks(options.pack_filename, &graphdata);
+        free_samples(&graphdata);
+        return status ? 0 : 1;
     }
 
-    glprogram = link_program(vs, fs);
-    if(!glprogram) {
-        lprintf("program link failed\n");
-        goto error;
+    if(options.downsample) {
+        snprintf(tmpstr, sizeof(tmpstr), "%s.lttb.txt", filename);
+        status = write_downsampled(tmpstr, &graphdata, options.downsample);
+        free_samples(&graphdata);
+        return status ? 0 : 1;
     }
 
-    glDeleteShader(fs);
-    glDeleteShader(vs);
+    if(options.anim_window) {
+        status = run_animate(&graphdata, filename);
+        free_samples(&graphdata);
+        return status ? 0 : 1;
+    }
+
+    lprintf("window: %dx%d\n", WIDTH, HEIGHT);
+    lprintf("color: #%02X%02X%02XFF\n", COLOR_R, COLOR_G, COLOR_B);
+    lprintf("msaa: %s\n", bool_to_string(graphdata.msaa));
+    lprintf("save: %s\n", bool_to_string(graphdata.save));
+    lprintf("compress: %s\n", bool_to_string(graphdata.compress));
+    lprintf("line_width: %f\n", graphdata.line_width);
+    lprintf("frame_px: %f\n", graphdata.frame_px);
 
-    mesh = malloc(sizeof(vec2_t) * graphdata.size);
-    assert(("Out of memory!", mesh));
-    for(i = 0; i < graphdata.size; i++) {
-        mesh[i][0] = (float)graphdata.frame_px + (float)i * (float)(WIDTH - graphdata.frame_px * 2) / (float)graphdata.size;
-        mesh[i][1] = (float)graphdata.frame_px + graphdata.data[i] / graphdata.max_value * (float)(HEIGHT - graphdata.frame_px * 2);
-        if(isinf(mesh[i][0]))
-            lprintf("warning: vertex[%zu].x = infinity\n", i);
-        else if(isnan(mesh[i][0]))
-            lprintf("warning: vertex[%zu].x = nan\n", i);
-        if(isinf(mesh[i][1]))
-            lprintf("warning: vertex[%zu].y = infinity\n", i);
-        else if(isnan(mesh[i][1]))
-            lprintf("warning: vertex[%zu].y = nan\n", i);
+    if(graphdata.frame_px <= FLT_EPSILON) {
+        /* this can cause the graph to sometimes go off limits */
+        lprintf("note: frame_px is close to zero. too bad!\n");
     }
 
-    glCreateBuffers(1, &glvbo);
-    glNamedBufferData(glvbo, sizeof(vec2_t) * graphdata.size, mesh, GL_STATIC_DRAW);
+    if(options.diff_filenames[0])
+        snprintf(tmpstr, sizeof(tmpstr), "UndGraph - %s vs %s", filename, options.diff_filenames[1]);
+    else
+        snprintf(tmpstr, sizeof(tmpstr), "UndGraph - %s", filename);
+    if(!init_gl(tmpstr, graphdata.msaa, 1))
+        return 1;
 
-    glCreateVertexArrays(1, &glvao);
-    glVertexArrayVertexBuffer(glvao, 0, glvbo, 0, sizeof(vec2_t));
-    glEnableVertexArrayAttrib(glvao, 0);
-    glVertexArrayAttribFormat(glvao, 0, 2, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribBinding(glvao, 0, 0);
+    upload_graph(&graphdata);
 
-    glLineWidth(graphdata.line_width);
+    if(options.follow && start_follow(&follow, &graphdata, filename)) {
+        upload_follow(&follow, &graphdata);
+        follow_title(&follow, filename);
+    }
+    else
+        options.follow = 0;
 
     while(!glfwWindowShouldClose(window)) {
         glfwPollEvents();
 
-        /* clear */
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        /* the title is kept to a few updates a second */
+        if(options.follow) {
+            if(poll_follow(&follow, &graphdata)) {
+                upload_follow(&follow, &graphdata);
+                follow.dirty = 1;
+            }
+            if(follow.dirty && now_seconds() - follow.title_time > 0.25)
+                follow_title(&follow, filename);
+        }
 
-        /* draw */
-        glBindVertexArray(glvao);
-        glUseProgram(glprogram);
-        glDrawArrays(GL_LINE_STRIP, 0, graphdata.size);
+        draw_graph(&graphdata);
 
         /* present */
         glfwSwapBuffers(window);
@@ -400,30 +8555,22 @@ int main(int argc, char **argv)
         /* now while we still need to save, do it */
         if(graphdata.save) {
             graphdata.save = 0;
-            pixels = malloc(3 * WIDTH * HEIGHT);
-            assert(("Out of memory!", pixels));
-            glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, pixels);
             snprintf(tmpstr, sizeof(tmpstr), "%s.png", filename);
-            stbi_flip_vertically_on_write(1);
-            stbi_write_png(tmpstr, WIDTH, HEIGHT, 3, pixels, 3 * WIDTH);
-            free(pixels);
+            save_png(tmpstr, graphdata.arena);
         }
     }
 
     /* cleanup */
-    glDeleteVertexArrays(1, &glvao);
-    glDeleteBuffers(1, &glvbo);
-    glDeleteProgram(glprogram);
+    if(options.follow)
+        stop_follow(&follow);
+    shutdown_gl();
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
-
-    free(graphdata.data);
+    free_samples(&graphdata);
+    arena_destroy(&file_arena);
+    if(options.diff_filenames[0])
+        arena_destroy(&diff_arena);
+    if(alert_file)
+        fclose(alert_file);
 
     return 0;
-
-error:
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return 1;
 }